@@ -0,0 +1,37 @@
+/** @file *//********************************************************************************************************
+
+                                                  AnimationClock.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/AnimationClock.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "AnimationClock.h"
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The global clock is shared by everything that does not need its own clock. It is meant to be advanced once per
+//! frame by the main loop.
+
+AnimationClock & AnimationClock::Global()
+{
+	static AnimationClock	clock;
+
+	return clock;
+}
+
+
+} // namespace Sdlx
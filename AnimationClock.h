@@ -0,0 +1,64 @@
+/** @file *//********************************************************************************************************
+
+                                                   AnimationClock.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/AnimationClock.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! A clock that drives animations
+//
+//! Animated sprites that are driven by a clock do not need to be serviced. Instead, they compute their current
+//! frame from the clock's time when they are drawn or queried. Advancing the clock once per frame advances all the
+//! sprites driven by it.
+//!
+//! The time is kept in double precision so that it does not lose precision during a long session.
+
+class AnimationClock
+{
+public:
+
+	//! Constructor
+	AnimationClock() : m_time( 0.0 ), m_scale( 1.0f )	{}
+
+	//! Advances the time (in seconds)
+	void Advance( float elapsed )						{ m_time += elapsed * m_scale; }
+
+	//! Sets the time (in seconds)
+	void SetTime( double time )							{ m_time = time; }
+
+	//! Returns the time (in seconds)
+	double GetTime() const								{ return m_time; }
+
+	//! Sets the rate of the clock (0 pauses the clock)
+	void SetScale( float scale )						{ m_scale = scale; }
+
+	//! Returns the rate of the clock
+	float GetScale() const								{ return m_scale; }
+
+	//! Returns the global clock
+	static AnimationClock & Global();
+
+private:
+
+	double	m_time;		// The current time
+	float	m_scale;	// The rate of the clock
+};
+
+
+} // namespace Sdlx
@@ -0,0 +1,652 @@
+/** @file *//********************************************************************************************************
+
+                                                    BitmapFont.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/BitmapFont.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "BitmapFont.h"
+
+#include "MemoryTracker.h"
+#include "Sdlx.h"
+
+namespace
+{
+
+	// Returns the value of a pixel in a locked surface
+
+	Uint32 GetPixel( SDL_Surface const * surface, int x, int y )
+	{
+		int				bpp	= surface->format->BytesPerPixel;
+		Uint8 const *	p	= static_cast< Uint8 const * >( surface->pixels ) + y * surface->pitch + x * bpp;
+
+		switch ( bpp )
+		{
+		case 1:
+			return *p;
+
+		case 2:
+			return *reinterpret_cast< Uint16 const * >( p );
+
+		case 3:
+#if SDL_BYTEORDER == SDL_BIG_ENDIAN
+			return ( p[0] << 16 ) | ( p[1] << 8 ) | p[2];
+#else
+			return p[0] | ( p[1] << 8 ) | ( p[2] << 16 );
+#endif
+
+		default:
+			return *reinterpret_cast< Uint32 const * >( p );
+		}
+	}
+
+
+	// Returns true if a column of a locked surface contains a pixel that does not match the color key
+
+	bool IsColumnUsed( SDL_Surface const * surface, int x, int top, int h )
+	{
+		Uint32	key	= surface->format->colorkey;
+
+		for ( int y = top; y < top + h; ++y )
+		{
+			if ( GetPixel( surface, x, y ) != key )
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+
+	// Returns true if two rects overlap
+
+	bool Intersects( SDL_Rect const & a, SDL_Rect const & b )
+	{
+		return	a.x < b.x + b.w && b.x < a.x + a.w &&
+				a.y < b.y + b.h && b.y < a.y + a.h;
+	}
+
+
+} // anonymous namespace
+
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	sheet				SDL_Surface containing the glyphs. The sheet must have a color key.
+//! @param	first				character code of the first glyph
+//! @param	glyphs				the glyphs, in character order
+//! @param	lineHeight			distance between lines
+//! @param	maxCachedLayouts	maximum number of strings whose layouts are cached
+//!
+//! @note	The font assumes ownership of the sheet and frees it using FreeImage().
+
+BitmapFont::BitmapFont( SDL_Surface *		sheet,
+						int					first,
+						GlyphList const &	glyphs,
+						int					lineHeight,
+						int					maxCachedLayouts/* = 256*/ )
+	:	m_sheet( sheet ),
+		m_first( first ),
+		m_glyphs( glyphs ),
+		m_lineHeight( lineHeight ),
+		m_maxCachedLayouts( maxCachedLayouts )
+{
+	assert( sheet != 0 );
+	assert( ( sheet->flags & SDL_SRCCOLORKEY ) != 0 );
+	assert( maxCachedLayouts > 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+BitmapFont::~BitmapFont()
+{
+	ReleaseRendered();
+	FreeImage( m_sheet );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function loads a font from an image file whose glyphs are laid out in a grid of equal-sized cells, left
+//! to right and top to bottom, in character order. The image is loaded with LoadColorKeyedImage(). Ownership of
+//! the font is passed to the caller. The font must be deallocated using delete.
+//!
+//! If the font is proportional, the blank columns on either side of each glyph are trimmed and the advance of
+//! each glyph is its trimmed width plus the spacing. A blank glyph (such as a space) has an advance of half of
+//! the cell width. Otherwise, each glyph is the entire cell and its advance is the cell width plus the spacing.
+//!
+//! @param	filename		name of the file to load
+//! @param	key				color key
+//! @param	cellWidth		width of each cell
+//! @param	cellHeight		height of each cell (and the distance between lines)
+//! @param	first			character code of the glyph in the first cell
+//! @param	count			number of glyphs. If the sheet has fewer cells, only those cells are used.
+//! @param	proportional	if true, the blank columns in each cell are trimmed
+//! @param	spacing			additional distance between glyphs
+//! @param	format			format to convert to. If 0, the image is converted to the format of the display.
+//!
+//! @return		the new font, or 0 if error
+
+BitmapFont * BitmapFont::Load( char const *			filename,
+							   SDL_Color			key,
+							   int					cellWidth,
+							   int					cellHeight,
+							   int					first/* = ' '*/,
+							   int					count/* = 96*/,
+							   bool					proportional/* = false*/,
+							   int					spacing/* = 0*/,
+							   SDL_PixelFormat *	format/* = 0*/ )
+{
+	assert( cellWidth > 0 && cellHeight > 0 );
+	assert( count > 0 );
+
+	SDL_Surface *	sheet	= LoadColorKeyedImage( filename, key, format );
+
+	if ( sheet == 0 )
+	{
+		return 0;
+	}
+
+	int	columns	= sheet->w / cellWidth;
+	int	rows	= sheet->h / cellHeight;
+
+	count = std::min( count, columns * rows );
+	if ( count <= 0 )
+	{
+		FreeImage( sheet );
+		return 0;
+	}
+
+	// The sheet must be locked to read its pixels because it is RLE-encoded
+
+	if ( proportional )
+	{
+		SDL_LockSurface( sheet );
+	}
+
+	GlyphList	glyphs( count );
+
+	for ( int i = 0; i < count; ++i )
+	{
+		Glyph &	glyph	= glyphs[ i ];
+		int		x		= ( i % columns ) * cellWidth;
+		int		y		= ( i / columns ) * cellHeight;
+
+		glyph.rect		= MakeRect( x, y, cellWidth, cellHeight );
+		glyph.offsetX	= 0;
+		glyph.offsetY	= 0;
+		glyph.advance	= cellWidth + spacing;
+
+		if ( proportional )
+		{
+			int	left	= x;
+			int	right	= x + cellWidth;
+
+			while ( left < right && !IsColumnUsed( sheet, left, y, cellHeight ) )
+			{
+				++left;
+			}
+
+			while ( right > left && !IsColumnUsed( sheet, right - 1, y, cellHeight ) )
+			{
+				--right;
+			}
+
+			if ( left < right )
+			{
+				glyph.rect.x	= Sint16( left );
+				glyph.rect.w	= Uint16( right - left );
+				glyph.advance	= right - left + spacing;
+			}
+			else
+			{
+				glyph.rect.w	= 0;
+				glyph.advance	= cellWidth / 2 + spacing;
+			}
+		}
+	}
+
+	if ( proportional )
+	{
+		SDL_UnlockSurface( sheet );
+	}
+
+	return new BitmapFont( sheet, first, glyphs, cellHeight );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	text	string to draw
+//! @param	dst		destination surface
+//! @param	x,y		location of the UL corner of the string
+
+void BitmapFont::Draw( char const * text, SDL_Surface * dst, int x, int y )
+{
+	PlacementList const &	placements	= GetLayout( text ).placements;
+
+	for ( PlacementList::const_iterator i = placements.begin(); i != placements.end(); ++i )
+	{
+		DrawGlyph( i->glyph, dst, x + i->x, y + i->y );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function renders a string to its own surface, so that drawing it requires only a single blit. The
+//! surface has the same color key as the sheet. The surface is cached, so subsequent calls with the same string
+//! return the same surface.
+//!
+//! @param	text	string to render
+//!
+//! @return		the surface containing the string, or 0 if error
+//!
+//! @note	The font retains ownership of the surface. It is freed when the font is destroyed or when
+//!			ReleaseRendered() is called.
+
+SDL_Surface * BitmapFont::Render( char const * text )
+{
+	RenderedMap::iterator	pRendered	= m_rendered.find( text );
+
+	if ( pRendered != m_rendered.end() )
+	{
+		return pRendered->second;
+	}
+
+	Layout const &	layout	= GetLayout( text );
+	SDL_Surface *	surface	= CreateSurface( std::max( layout.w, 1 ), std::max( layout.h, 1 ) );
+
+	if ( surface == 0 )
+	{
+		return 0;
+	}
+
+	for ( PlacementList::const_iterator i = layout.placements.begin(); i != layout.placements.end(); ++i )
+	{
+		DrawGlyph( i->glyph, surface, i->x, i->y );
+	}
+
+	// The string will not change, so the surface can be RLE-encoded
+
+	SDL_SetColorKey( surface, SDL_SRCCOLORKEY | SDL_RLEACCEL, m_sheet->format->colorkey );
+	MemoryTracker::Instance().Refresh( surface );
+
+	m_rendered.insert( RenderedMap::value_type( text, surface ) );
+
+	return surface;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void BitmapFont::ReleaseRendered()
+{
+	for ( RenderedMap::iterator i = m_rendered.begin(); i != m_rendered.end(); ++i )
+	{
+		FreeImage( i->second );
+	}
+
+	m_rendered.clear();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function returns the layout of a string from the cache, laying it out and adding it to the cache if
+//! necessary. When the cache is full, the least recently used layout is removed.
+//!
+//! @param	text	string to lay out
+//!
+//! @note	The returned reference is valid until the next call to GetLayout(), Draw(), or Render().
+
+BitmapFont::Layout const & BitmapFont::GetLayout( char const * text )
+{
+	LayoutCache::iterator	pCached	= m_layouts.find( text );
+
+	if ( pCached != m_layouts.end() )
+	{
+		m_lru.splice( m_lru.begin(), m_lru, pCached->second.lruPos );
+		return pCached->second.layout;
+	}
+
+	if ( int( m_layouts.size() ) >= m_maxCachedLayouts )
+	{
+		m_layouts.erase( m_lru.back() );
+		m_lru.pop_back();
+	}
+
+	m_lru.push_front( text );
+
+	CachedLayout &	cached	= m_layouts[ m_lru.front() ];
+
+	cached.lruPos = m_lru.begin();
+	LayOut( text, &cached.layout );
+
+	return cached.layout;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	text		string to lay out
+//! @param	pLayout		where to put the layout
+
+void BitmapFont::LayOut( char const * text, Layout * pLayout ) const
+{
+	int	x	= 0;
+	int	y	= 0;
+	int	w	= 0;
+	int	h	= 0;
+
+	pLayout->placements.clear();
+
+	for ( unsigned char const * p = reinterpret_cast< unsigned char const * >( text ); *p != 0; ++p )
+	{
+		if ( *p == '\n' )
+		{
+			w = std::max( w, x );
+			x = 0;
+			y += m_lineHeight;
+			continue;
+		}
+
+		int	index	= *p - m_first;
+
+		if ( index < 0 || index >= int( m_glyphs.size() ) )
+		{
+			continue;
+		}
+
+		Glyph const &	glyph	= m_glyphs[ index ];
+
+		if ( glyph.rect.w > 0 && glyph.rect.h > 0 )
+		{
+			Placement	placement;
+
+			placement.glyph	= index;
+			placement.x		= x + glyph.offsetX;
+			placement.y		= y + glyph.offsetY;
+
+			pLayout->placements.push_back( placement );
+
+			w = std::max( w, placement.x + glyph.rect.w );
+			h = std::max( h, placement.y + glyph.rect.h );
+		}
+
+		x += glyph.advance;
+	}
+
+	pLayout->w = std::max( w, x );
+	pLayout->h = std::max( h, y + m_lineHeight );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	glyph	index of the glyph
+//! @param	dst		destination surface
+//! @param	x,y		location of the UL corner of the glyph
+
+void BitmapFont::DrawGlyph( int glyph, SDL_Surface * dst, int x, int y ) const
+{
+	SDL_Rect	source		= m_glyphs[ glyph ].rect;
+	SDL_Rect	position	= MakeRect( x, y, 0, 0 );
+
+	SDL_BlitSurface( m_sheet, &source, dst, &position );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The surface is not RLE-encoded, so it can be drawn to efficiently. Ownership of the surface is passed to the
+//! caller. The surface must be deallocated using FreeImage().
+//!
+//! @param	w,h		size of the surface
+//!
+//! @return		the new surface, or 0 if error
+
+SDL_Surface * BitmapFont::CreateSurface( int w, int h ) const
+{
+	SDL_PixelFormat const *	format	= m_sheet->format;		// Convenience
+	SDL_Surface *			surface	= SDL_CreateRGBSurface( SDL_SWSURFACE, w, h, format->BitsPerPixel,
+															format->Rmask, format->Gmask, format->Bmask, format->Amask );
+
+	if ( surface == 0 )
+	{
+		return 0;
+	}
+
+	if ( format->palette != 0 )
+	{
+		SDL_SetColors( surface, format->palette->colors, 0, format->palette->ncolors );
+	}
+
+	SDL_FillRect( surface, 0, format->colorkey );
+	SDL_SetColorKey( surface, SDL_SRCCOLORKEY, format->colorkey );
+
+	MemoryTracker::Instance().AddSurface( surface, "BitmapFont" );
+
+	return surface;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	font	font used to draw the string
+//! @param	text	initial string
+
+TextLabel::TextLabel( BitmapFont const * font, char const * text/* = ""*/ )
+	:	m_pFont( font ),
+		m_surface( 0 )
+{
+	assert( font != 0 );
+
+	m_layout.w = 0;
+	m_layout.h = 0;
+
+	SetText( text );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+TextLabel::~TextLabel()
+{
+	FreeImage( m_surface );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The new string is compared with the old string glyph by glyph. The areas of the glyphs that were added,
+//! removed, changed, or moved are cleared, and then only the glyphs that overlap those areas are drawn. If the new
+//! string does not fit in the label's surface, the surface is enlarged and the entire string is drawn.
+//!
+//! @param	text	new string
+
+void TextLabel::SetText( char const * text )
+{
+	if ( m_surface != 0 && m_text == text )
+	{
+		return;
+	}
+
+	typedef BitmapFont::PlacementList	PlacementList;
+
+	BitmapFont::Layout	layout;
+
+	m_pFont->LayOut( text, &layout );
+
+	PlacementList const &	oldPlacements	= m_layout.placements;	// Convenience
+	PlacementList const &	newPlacements	= layout.placements;	// Convenience
+
+	if ( m_surface == 0 || layout.w > m_surface->w || layout.h > m_surface->h )
+	{
+		// Enlarge the surface (with some room to grow) and draw the entire string
+
+		int	w	= m_surface ? m_surface->w : 0;
+		int	h	= m_surface ? m_surface->h : 0;
+
+		if ( layout.w > w )
+		{
+			w = std::max( layout.w + layout.w / 4, 1 );
+		}
+
+		if ( layout.h > h )
+		{
+			h = std::max( layout.h, 1 );
+		}
+
+		Resize( w, h );
+		if ( m_surface == 0 )
+		{
+			m_text.clear();
+			m_layout.placements.clear();
+			m_layout.w = 0;
+			m_layout.h = 0;
+			return;
+		}
+
+		for ( PlacementList::const_iterator i = newPlacements.begin(); i != newPlacements.end(); ++i )
+		{
+			m_pFont->DrawGlyph( i->glyph, m_surface, i->x, i->y );
+		}
+	}
+	else
+	{
+		// Find the areas that changed
+
+		std::vector< SDL_Rect >	dirty;
+		size_t					n	= std::max( oldPlacements.size(), newPlacements.size() );
+
+		for ( size_t i = 0; i < n; ++i )
+		{
+			BitmapFont::Placement const *	pOld	= ( i < oldPlacements.size() ) ? &oldPlacements[ i ] : 0;
+			BitmapFont::Placement const *	pNew	= ( i < newPlacements.size() ) ? &newPlacements[ i ] : 0;
+
+			if ( pOld != 0 && pNew != 0 && pOld->glyph == pNew->glyph && pOld->x == pNew->x && pOld->y == pNew->y )
+			{
+				continue;
+			}
+
+			if ( pOld != 0 )
+			{
+				SDL_Rect const &	rect	= m_pFont->GetGlyph( pOld->glyph ).rect;
+
+				dirty.push_back( MakeRect( pOld->x, pOld->y, rect.w, rect.h ) );
+			}
+
+			if ( pNew != 0 )
+			{
+				SDL_Rect const &	rect	= m_pFont->GetGlyph( pNew->glyph ).rect;
+
+				dirty.push_back( MakeRect( pNew->x, pNew->y, rect.w, rect.h ) );
+			}
+		}
+
+		// Clear the changed areas and redraw the glyphs that overlap them
+
+		Uint32	key	= m_surface->format->colorkey;
+
+		for ( std::vector< SDL_Rect >::iterator r = dirty.begin(); r != dirty.end(); ++r )
+		{
+			SDL_Rect	clear	= *r;	// SDL_FillRect modifies the rect
+
+			SDL_FillRect( m_surface, &clear, key );
+		}
+
+		for ( PlacementList::const_iterator i = newPlacements.begin(); i != newPlacements.end(); ++i )
+		{
+			SDL_Rect const &	rect	= m_pFont->GetGlyph( i->glyph ).rect;
+			SDL_Rect			area	= MakeRect( i->x, i->y, rect.w, rect.h );
+
+			for ( std::vector< SDL_Rect >::const_iterator r = dirty.begin(); r != dirty.end(); ++r )
+			{
+				if ( Intersects( area, *r ) )
+				{
+					m_pFont->DrawGlyph( i->glyph, m_surface, i->x, i->y );
+					break;
+				}
+			}
+		}
+	}
+
+	m_text		= text;
+	m_layout	= layout;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	dst		destination surface
+//! @param	x,y		location of the UL corner of the string
+
+void TextLabel::Draw( SDL_Surface * dst, int x, int y ) const
+{
+	if ( m_layout.w > 0 && m_layout.h > 0 )
+	{
+		SDL_Rect	source		= MakeRect( 0, 0, m_layout.w, m_layout.h );
+		SDL_Rect	position	= MakeRect( x, y, 0, 0 );
+
+		SDL_BlitSurface( m_surface, &source, dst, &position );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Replaces the surface with a new, empty one
+
+void TextLabel::Resize( int w, int h )
+{
+	FreeImage( m_surface );
+	m_surface = m_pFont->CreateSurface( w, h );
+}
+
+
+} // namespace Sdlx
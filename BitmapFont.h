@@ -0,0 +1,202 @@
+/** @file *//********************************************************************************************************
+
+                                                     BitmapFont.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/BitmapFont.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include <SDL.h>
+
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! A font whose glyphs are images on a color-keyed sheet
+//
+//! The glyphs of a bitmap font are sub-regions of a single sheet. Each glyph has an offset from the pen position
+//! to its UL corner and an advance, which is the distance the pen moves after the glyph is drawn. A font is usually
+//! loaded from a sheet whose glyphs are laid out in a grid of equal-sized cells, in character order.
+//!
+//! The layout of a string (the location of each of its glyphs) is cached, so drawing the same string repeatedly
+//! does not lay it out again. A string that never changes can also be rendered once to its own surface with
+//! Render(), after which drawing it is a single blit. For strings that change, such as counters, use a TextLabel.
+//!
+//! Strings may contain several lines separated by '\\n'. Characters without a glyph are ignored.
+
+class BitmapFont
+{
+public:
+
+	//! A glyph
+	struct Glyph
+	{
+		SDL_Rect	rect;		//!< Location and size of the glyph in the sheet
+		int			offsetX;	//!< Offset from the pen position to the UL corner of the glyph
+		int			offsetY;	//!< Offset from the pen position to the UL corner of the glyph
+		int			advance;	//!< Distance the pen moves after drawing the glyph
+	};
+
+	//! A vector of glyphs
+	typedef std::vector< Glyph >	GlyphList;
+
+	//! The location of a glyph in a string
+	struct Placement
+	{
+		int		glyph;		//!< Index of the glyph
+		int		x, y;		//!< Location of the UL corner of the glyph relative to the UL corner of the string
+	};
+
+	//! A vector of placements
+	typedef std::vector< Placement >	PlacementList;
+
+	//! The layout of a string
+	struct Layout
+	{
+		PlacementList	placements;		//!< The location of each glyph
+		int				w, h;			//!< Size of the string
+	};
+
+	//! Constructor
+	BitmapFont( SDL_Surface *		sheet,
+				int					first,
+				GlyphList const &	glyphs,
+				int					lineHeight,
+				int					maxCachedLayouts = 256 );
+
+	// Destructor
+	virtual ~BitmapFont();
+
+	//! Loads a font from a sheet whose glyphs are laid out in a grid
+	static BitmapFont * Load( char const *		filename,
+							  SDL_Color			key,
+							  int				cellWidth,
+							  int				cellHeight,
+							  int				first = ' ',
+							  int				count = 96,
+							  bool				proportional = false,
+							  int				spacing = 0,
+							  SDL_PixelFormat *	format = 0 );
+
+	//! Draws a string
+	void Draw( char const * text, SDL_Surface * dst, int x, int y );
+
+	//! Returns a surface containing a string
+	SDL_Surface * Render( char const * text );
+
+	//! Frees the surfaces created by Render()
+	void ReleaseRendered();
+
+	//! Returns the layout of a string (cached)
+	Layout const & GetLayout( char const * text );
+
+	//! Lays out a string (not cached)
+	void LayOut( char const * text, Layout * pLayout ) const;
+
+	//! Draws a glyph
+	void DrawGlyph( int glyph, SDL_Surface * dst, int x, int y ) const;
+
+	//! Returns a glyph
+	Glyph const & GetGlyph( int glyph ) const		{ return m_glyphs[ glyph ]; }
+
+	//! Returns the distance between lines
+	int GetLineHeight() const						{ return m_lineHeight; }
+
+	//! Returns the sheet containing the glyphs
+	SDL_Surface * GetSheet() const					{ return m_sheet; }
+
+	//! Creates a color-keyed surface in the format of the sheet, cleared to the color key
+	SDL_Surface * CreateSurface( int w, int h ) const;
+
+private:
+
+	typedef std::list< std::string >	LruList;
+
+	// A cached layout
+	struct CachedLayout
+	{
+		Layout				layout;		// The layout
+		LruList::iterator	lruPos;		// The string's position in the LRU list
+	};
+
+	typedef std::map< std::string, CachedLayout >	LayoutCache;
+	typedef std::map< std::string, SDL_Surface * >	RenderedMap;
+
+	// Prevent copying
+	BitmapFont( BitmapFont const & );
+	BitmapFont & operator =( BitmapFont const & );
+
+	SDL_Surface *	m_sheet;				// The sheet containing the glyphs
+	int				m_first;				// Character code of the first glyph
+	GlyphList		m_glyphs;				// The glyphs
+	int				m_lineHeight;			// Distance between lines
+	int				m_maxCachedLayouts;		// Maximum number of cached layouts
+	LayoutCache		m_layouts;				// Cached layouts
+	LruList			m_lru;					// Strings of the cached layouts, most recently used first
+	RenderedMap		m_rendered;				// Surfaces created by Render()
+};
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! A string drawn with a bitmap font that can change
+//
+//! A text label keeps its string rendered on its own surface, so drawing it is a single blit. When the string
+//! changes, only the glyphs that changed (and any glyphs that they overlap) are redrawn. For example, when a score
+//! changes from 1299 to 1300, only the last three digits are redrawn.
+//!
+//! @note	The label does not assume ownership of the font.
+
+class TextLabel
+{
+public:
+
+	//! Constructor
+	TextLabel( BitmapFont const * font, char const * text = "" );
+
+	// Destructor
+	virtual ~TextLabel();
+
+	//! Changes the string
+	void SetText( char const * text );
+
+	//! Returns the string
+	char const * GetText() const				{ return m_text.c_str(); }
+
+	//! Draws the string
+	void Draw( SDL_Surface * dst, int x, int y ) const;
+
+private:
+
+	// Prevent copying
+	TextLabel( TextLabel const & );
+	TextLabel & operator =( TextLabel const & );
+
+	void Resize( int w, int h );
+
+	BitmapFont const *	m_pFont;		// The font
+	std::string			m_text;			// The string
+	BitmapFont::Layout	m_layout;		// The layout of the string
+	SDL_Surface *		m_surface;		// The rendered string
+};
+
+
+} // namespace Sdlx
@@ -0,0 +1,360 @@
+/** @file *//********************************************************************************************************
+
+                                                   FrameCapture.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/FrameCapture.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "FrameCapture.h"
+
+#include "Lock.h"
+#include "Sdlx.h"
+
+#include <cstring>
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! All buffers are allocated and the writer thread is started. Use IsValid() to determine if the capture was
+//! started successfully.
+//!
+//! @param	reference		A surface with the same size and format as the surfaces that will be captured. Paletted
+//!							surfaces are not supported.
+//! @param	filename		Name of the output file (FORMAT_RAW) or pattern used to generate the names of the output
+//!							files from the frame number (FORMAT_BMP). The pattern must contain exactly one integer
+//!							conversion (%d or %i, with a field width of up to 2 digits) and no other conversions.
+//! @param	format			Output file format
+//! @param	bufferCount		Number of frames that can be waiting to be written
+//! @param	policy			What to do when all buffers are waiting to be written
+
+FrameCapture::FrameCapture( SDL_Surface const *	reference,
+							char const *		filename,
+							Format				format/* = FORMAT_RAW*/,
+							int					bufferCount/* = 8*/,
+							Policy				policy/* = POLICY_DROP*/ )
+	:	m_width( reference->w ),
+		m_height( reference->h ),
+		m_bytesPerPixel( reference->format->BytesPerPixel ),
+		m_pitch( reference->w * reference->format->BytesPerPixel ),
+		m_filename( filename ),
+		m_format( format ),
+		m_policy( policy ),
+		m_fp( 0 ),
+		m_buffers( bufferCount, Buffer( reference->h * reference->w * reference->format->BytesPerPixel ) ),
+		m_head( 0 ),
+		m_tail( 0 ),
+		m_pending( 0 ),
+		m_captured( 0 ),
+		m_dropped( 0 ),
+		m_written( 0 ),
+		m_stop( false ),
+		m_pMutex( SDL_CreateMutex() ),
+		m_pFilled( SDL_CreateCond() ),
+		m_pEmptied( SDL_CreateCond() ),
+		m_pThread( 0 )
+{
+	assert( bufferCount > 0 );
+	assert( reference->format->BytesPerPixel > 1 );
+
+	m_masks[ 0 ] = reference->format->Rmask;
+	m_masks[ 1 ] = reference->format->Gmask;
+	m_masks[ 2 ] = reference->format->Bmask;
+	m_masks[ 3 ] = reference->format->Amask;
+
+	if ( m_format == FORMAT_RAW )
+	{
+		m_fp = fopen( filename, "wb" );
+		if ( m_fp == 0 )
+		{
+			return;
+		}
+	}
+	else
+	{
+		// The pattern is used as a printf format on the writer thread, so it must be validated
+
+		if ( !IsValidNumberPattern( filename, 1 ) )
+		{
+			return;
+		}
+	}
+
+	if ( m_pMutex != 0 && m_pFilled != 0 && m_pEmptied != 0 )
+	{
+		m_pThread = SDL_CreateThread( ThreadMain, this );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! All frames that have been captured are written before the capture is destroyed.
+
+FrameCapture::~FrameCapture()
+{
+	if ( m_pThread != 0 )
+	{
+		{
+			Lock	lock( m_pMutex );
+
+			m_stop = true;
+			SDL_CondSignal( m_pFilled );
+		}
+
+		SDL_WaitThread( m_pThread, 0 );
+	}
+
+	if ( m_fp != 0 )
+	{
+		fclose( m_fp );
+	}
+
+	SDL_DestroyCond( m_pEmptied );
+	SDL_DestroyCond( m_pFilled );
+	SDL_DestroyMutex( m_pMutex );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function copies the pixels of the surface into the next available buffer and queues it to be written. If
+//! no buffer is available, then either the frame is dropped or this function waits for a buffer, depending on the
+//! policy.
+//!
+//! @param	src		Surface to capture. It must have the same size and format as the reference surface.
+//!
+//! @return		true if the frame was captured, or false if it was dropped
+
+bool FrameCapture::Capture( SDL_Surface * src )
+{
+	assert( IsValid() );
+	assert( src->w == m_width && src->h == m_height );
+	assert( src->format->BytesPerPixel == m_bytesPerPixel );
+
+	// Wait for a buffer, or drop the frame if there isn't one
+
+	{
+		Lock	lock( m_pMutex );
+
+		if ( m_pending == int( m_buffers.size() ) )
+		{
+			if ( m_policy == POLICY_DROP )
+			{
+				++m_dropped;
+				return false;
+			}
+
+			while ( m_pending == int( m_buffers.size() ) )
+			{
+				SDL_CondWait( m_pEmptied, m_pMutex );
+			}
+		}
+	}
+
+	// Copy the pixels. The buffer at the head is not touched by the writer thread until it is queued, so the lock
+	// is not needed.
+
+	Uint8 *	pDst	= &m_buffers[ m_head ][ 0 ];
+
+	if ( SDL_MUSTLOCK( src ) )
+	{
+		SDL_LockSurface( src );
+	}
+
+	Uint8 const *	pSrc	= static_cast< Uint8 const * >( src->pixels );
+
+	if ( src->pitch == m_pitch )
+	{
+		memcpy( pDst, pSrc, m_pitch * m_height );
+	}
+	else
+	{
+		for ( int y = 0; y < m_height; ++y )
+		{
+			memcpy( pDst, pSrc, m_pitch );
+			pDst += m_pitch;
+			pSrc += src->pitch;
+		}
+	}
+
+	if ( SDL_MUSTLOCK( src ) )
+	{
+		SDL_UnlockSurface( src );
+	}
+
+	// Queue the buffer
+
+	{
+		Lock	lock( m_pMutex );
+
+		m_head = ( m_head + 1 ) % int( m_buffers.size() );
+		++m_pending;
+		SDL_CondSignal( m_pFilled );
+	}
+
+	++m_captured;
+
+	return true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void FrameCapture::Flush()
+{
+	Lock	lock( m_pMutex );
+
+	while ( m_pending > 0 )
+	{
+		SDL_CondWait( m_pEmptied, m_pMutex );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+int FrameCapture::GetWrittenCount() const
+{
+	Lock	lock( m_pMutex );
+
+	return m_written;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+int FrameCapture::GetPendingCount() const
+{
+	Lock	lock( m_pMutex );
+
+	return m_pending;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+int FrameCapture::ThreadMain( void * pData )
+{
+	static_cast< FrameCapture * >( pData )->WriteFrames();
+
+	return 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void FrameCapture::WriteFrames()
+{
+	int	frame	= 0;
+
+	for ( ;; )
+	{
+		int	index;
+
+		// Wait for a buffer to be filled. Exit only after all filled buffers have been written.
+
+		{
+			Lock	lock( m_pMutex );
+
+			while ( m_pending == 0 && !m_stop )
+			{
+				SDL_CondWait( m_pFilled, m_pMutex );
+			}
+
+			if ( m_pending == 0 )
+			{
+				return;
+			}
+
+			index = m_tail;
+		}
+
+		// Write the buffer. The buffer at the tail is not touched by the capturing thread until it is released, so
+		// the lock is not needed.
+
+		bool	ok	= Write( m_buffers[ index ], frame );
+
+		++frame;
+
+		// Release the buffer
+
+		{
+			Lock	lock( m_pMutex );
+
+			m_tail = ( m_tail + 1 ) % int( m_buffers.size() );
+			--m_pending;
+			if ( ok )
+			{
+				++m_written;
+			}
+			SDL_CondBroadcast( m_pEmptied );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+bool FrameCapture::Write( Buffer const & buffer, int frame )
+{
+	if ( m_format == FORMAT_RAW )
+	{
+		return fwrite( &buffer[ 0 ], buffer.size(), 1, m_fp ) == 1;
+	}
+	else
+	{
+		// The pattern has been validated by the constructor, so the conversion produces at most 99 characters
+
+		std::vector< char >	name( m_filename.size() + 128 );
+
+		snprintf( &name[ 0 ], name.size(), m_filename.c_str(), frame );
+		name.back() = 0;
+
+		SDL_Surface *	surface	= SDL_CreateRGBSurfaceFrom( const_cast< Uint8 * >( &buffer[ 0 ] ),
+															m_width, m_height,
+															m_bytesPerPixel * 8, m_pitch,
+															m_masks[ 0 ], m_masks[ 1 ], m_masks[ 2 ], m_masks[ 3 ] );
+		if ( surface == 0 )
+		{
+			return false;
+		}
+
+		int	rv	= SDL_SaveBMP( surface, &name[ 0 ] );
+
+		SDL_FreeSurface( surface );
+
+		return rv == 0;
+	}
+}
+
+
+} // namespace Sdlx
@@ -0,0 +1,133 @@
+/** @file *//********************************************************************************************************
+
+                                                    FrameCapture.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/FrameCapture.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include <SDL.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! Captures frames to disk asynchronously
+//
+//! Capture() copies the pixels of a surface (typically the surface that sprites are drawn to) into one of a fixed
+//! number of preallocated buffers, and a background thread writes the buffers to disk. The cost to the caller is a
+//! single copy of the pixels. If all buffers are waiting to be written, the frame is either dropped or the caller
+//! waits for a buffer, depending on the policy.
+//!
+//! Output formats
+//!
+//! - FORMAT_RAW: All frames are written consecutively to a single file. Each frame is width * height * bytes per
+//!		pixel bytes, with no padding between rows, in the pixel format of the captured surface.
+//! - FORMAT_BMP: Each frame is written to its own BMP file. The file name is generated from a printf-style pattern
+//!		and the frame number (for example, "capture_%05d.bmp"). The pattern must contain exactly one integer
+//!		conversion and no other conversions, otherwise the capture is not started.
+
+class FrameCapture
+{
+public:
+
+	//! Output file format
+	enum Format
+	{
+		FORMAT_RAW,		//!< Raw frames in a single file
+		FORMAT_BMP		//!< A sequence of BMP files
+	};
+
+	//! What to do when all buffers are waiting to be written
+	enum Policy
+	{
+		POLICY_DROP,	//!< Drop the frame
+		POLICY_WAIT		//!< Wait until a buffer is available
+	};
+
+	//! Constructor
+	FrameCapture( SDL_Surface const *	reference,
+				  char const *			filename,
+				  Format				format = FORMAT_RAW,
+				  int					bufferCount = 8,
+				  Policy				policy = POLICY_DROP );
+
+	// Destructor
+	virtual ~FrameCapture();
+
+	//! Returns true if the capture was started successfully
+	bool IsValid() const						{ return m_pThread != 0; }
+
+	//! Captures a frame
+	bool Capture( SDL_Surface * src );
+
+	//! Waits until all captured frames have been written
+	void Flush();
+
+	//! Returns the number of frames captured
+	int GetCapturedCount() const				{ return m_captured; }
+
+	//! Returns the number of frames dropped
+	int GetDroppedCount() const					{ return m_dropped; }
+
+	//! Returns the number of frames written
+	int GetWrittenCount() const;
+
+	//! Returns the number of frames waiting to be written
+	int GetPendingCount() const;
+
+private:
+
+	typedef std::vector< Uint8 >	Buffer;
+	typedef std::vector< Buffer >	BufferList;
+
+	// Prevent copying
+	FrameCapture( FrameCapture const & );
+	FrameCapture & operator =( FrameCapture const & );
+
+	static int ThreadMain( void * pData );
+	void WriteFrames();
+	bool Write( Buffer const & buffer, int frame );
+
+	int				m_width;			// Width of a frame
+	int				m_height;			// Height of a frame
+	int				m_bytesPerPixel;	// Bytes per pixel of a frame
+	int				m_pitch;			// Bytes per row of a frame
+	Uint32			m_masks[ 4 ];		// Red, green, blue and alpha masks of a frame
+	std::string		m_filename;			// Output file name or pattern
+	Format			m_format;			// Output file format
+	Policy			m_policy;			// What to do when all buffers are waiting to be written
+	FILE *			m_fp;				// Output file (FORMAT_RAW only)
+
+	BufferList		m_buffers;			// The ring of frame buffers
+	int				m_head;				// Index of the next buffer to fill
+	int				m_tail;				// Index of the next buffer to write
+	int				m_pending;			// Number of buffers waiting to be written
+	int				m_captured;			// Number of frames captured
+	int				m_dropped;			// Number of frames dropped
+	int				m_written;			// Number of frames written
+	bool			m_stop;				// True if the writer thread should exit
+
+	SDL_mutex *		m_pMutex;			// Guards the ring state
+	SDL_cond *		m_pFilled;			// Signaled when a buffer has been filled
+	SDL_cond *		m_pEmptied;			// Signaled when a buffer has been written
+	SDL_Thread *	m_pThread;			// The writer thread
+};
+
+
+} // namespace Sdlx
@@ -0,0 +1,112 @@
+/** @file *//********************************************************************************************************
+
+                                                     Headless.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/Headless.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "Headless.h"
+
+namespace
+{
+
+	// A surface whose only purpose is to hold the pixel format of offscreen surfaces
+	SDL_Surface *	s_pFormatSurface	= 0;
+
+
+} // anonymous namespace
+
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function initializes SDL with the "dummy" video driver, so no window is created and no display is needed.
+//! The video mode is not set, so SDL_DisplayFormat cannot be used. Instead, images should be loaded in the format
+//! returned by GetHeadlessFormat(), for example:
+//!
+//! @code
+//!		SDL_Surface * sheet = Sdlx::LoadImage( "sheet.png", Sdlx::GetHeadlessFormat() );
+//! @endcode
+//!
+//! Sprites are drawn into surfaces created by CreateOffscreenSurface().
+//!
+//! @return		true if successful
+
+bool InitHeadless()
+{
+	static char	driver[]	= "SDL_VIDEODRIVER=dummy";
+
+	SDL_putenv( driver );
+
+	if ( SDL_Init( SDL_INIT_VIDEO | SDL_INIT_NOPARACHUTE ) != 0 )
+	{
+		return false;
+	}
+
+	s_pFormatSurface = CreateOffscreenSurface( 1, 1 );
+
+	return s_pFormatSurface != 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void QuitHeadless()
+{
+	if ( s_pFormatSurface != 0 )
+	{
+		SDL_FreeSurface( s_pFormatSurface );
+		s_pFormatSurface = 0;
+	}
+
+	SDL_Quit();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The format is 32 bits per pixel with no alpha channel.
+//!
+//! @return		the format, or 0 if InitHeadless() has not been called
+
+SDL_PixelFormat * GetHeadlessFormat()
+{
+	return ( s_pFormatSurface != 0 ) ? s_pFormatSurface->format : 0;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function creates a software surface in the format returned by GetHeadlessFormat(). It does not require the
+//! video mode to be set. The surface must be freed with SDL_FreeSurface.
+//!
+//! @param	w,h		size of the surface
+//!
+//! @return		the new surface, or 0 if error
+
+SDL_Surface * CreateOffscreenSurface( int w, int h )
+{
+	return SDL_CreateRGBSurface( SDL_SWSURFACE, w, h, 32, 0x00ff0000, 0x0000ff00, 0x000000ff, 0 );
+}
+
+
+} // namespace Sdlx
@@ -0,0 +1,33 @@
+/** @file *//********************************************************************************************************
+
+                                                      Headless.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/Headless.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include <SDL.h>
+
+namespace Sdlx
+{
+	//! Initializes SDL for rendering without a display.
+	bool InitHeadless();
+
+	//! Shuts down SDL after InitHeadless.
+	void QuitHeadless();
+
+	//! Returns the pixel format of offscreen surfaces.
+	SDL_PixelFormat * GetHeadlessFormat();
+
+	//! Creates an offscreen surface.
+	SDL_Surface * CreateOffscreenSurface( int w, int h );
+
+} // namespace Sdlx
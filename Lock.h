@@ -0,0 +1,48 @@
+/** @file *//********************************************************************************************************
+
+                                                        Lock.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/Lock.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include <SDL.h>
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! Locks a mutex for the lifetime of the object
+
+class Lock
+{
+public:
+
+	//! Constructor
+	explicit Lock( SDL_mutex * pMutex ) : m_pMutex( pMutex )	{ SDL_LockMutex( m_pMutex ); }
+
+	// Destructor
+	~Lock()														{ SDL_UnlockMutex( m_pMutex ); }
+
+private:
+
+	// Prevent copying
+	Lock( Lock const & );
+	Lock & operator =( Lock const & );
+
+	SDL_mutex *	m_pMutex;	// The locked mutex
+};
+
+
+} // namespace Sdlx
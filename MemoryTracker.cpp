@@ -0,0 +1,531 @@
+/** @file *//********************************************************************************************************
+
+                                                   MemoryTracker.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/MemoryTracker.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "MemoryTracker.h"
+
+#include "Lock.h"
+
+namespace
+{
+
+	// Returns the number of bytes used by a surface. If the surface is RLE-accelerated, the size of the encoded data
+	// is not available, so the size of the unencoded data is returned instead.
+
+	size_t SurfaceBytes( SDL_Surface const * surface )
+	{
+		size_t	bytes	= sizeof( SDL_Surface ) + sizeof( SDL_PixelFormat ) + size_t( surface->h ) * surface->pitch;
+
+		if ( surface->format->palette != 0 )
+		{
+			bytes += sizeof( SDL_Palette ) + surface->format->palette->ncolors * sizeof( SDL_Color );
+		}
+
+		return bytes;
+	}
+
+
+	// Returns the number of bytes used by an animation group
+
+	size_t AnimationGroupBytes( Sdlx::AnimatedSprite::AnimationGroup const * group )
+	{
+		typedef Sdlx::AnimatedSprite::AnimationGroup	AnimationGroup;
+		typedef Sdlx::AnimatedSprite::Animation			Animation;
+
+		size_t	bytes	= sizeof( AnimationGroup )
+						+ group->images.capacity() * sizeof( AnimationGroup::Image )
+						+ group->animations.capacity() * sizeof( Animation );
+
+		for ( AnimationGroup::AnimationList::const_iterator i = group->animations.begin(); i != group->animations.end(); ++i )
+		{
+			bytes += i->frames.capacity() * sizeof( Sdlx::AnimatedSprite::Frame );
+		}
+
+		return bytes;
+	}
+
+
+} // anonymous namespace
+
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+MemoryTracker::MemoryTracker()
+	:	m_pMutex( SDL_CreateMutex() ),
+		m_budget( 0 ),
+		m_pBudgetCB( 0 ),
+		m_reportInterval( 0 ),
+		m_nextReport( 0 ),
+		m_pReportCB( 0 )
+{
+	assert( m_pMutex != 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+MemoryTracker::~MemoryTracker()
+{
+	SDL_DestroyMutex( m_pMutex );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The tracker is created the first time this function is called.
+
+MemoryTracker & MemoryTracker::Instance()
+{
+	static MemoryTracker	tracker;
+
+	return tracker;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	surface		Surface to register
+//! @param	source		Name of the file the surface was loaded from (or 0 if none)
+
+void MemoryTracker::AddSurface( SDL_Surface const * surface, char const * source/* = 0*/ )
+{
+	assert( surface != 0 );
+
+	Add( TYPE_SURFACE, surface, source );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	group		Animation group to register
+//! @param	source		Name of the file the group was loaded from (or 0 if none)
+
+void MemoryTracker::AddAnimationGroup( AnimatedSprite::AnimationGroup const * group, char const * source/* = 0*/ )
+{
+	assert( group != 0 );
+
+	Add( TYPE_ANIMATION_GROUP, group, source );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	pObject		Object to unregister. If the object is not registered, nothing happens.
+
+void MemoryTracker::Remove( void const * pObject )
+{
+	Lock	lock( m_pMutex );
+
+	m_records.erase( pObject );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! Objects are only measured when they are registered. This function must be called to update the measurements
+//! of an object after it has changed (for example, after a color key is applied to a surface).
+//!
+//! @param	pObject		Object to measure. If the object is not registered, nothing happens.
+
+void MemoryTracker::Refresh( void const * pObject )
+{
+	{
+		Lock	lock( m_pMutex );
+
+		RecordMap::iterator	pRecord	= m_records.find( pObject );
+
+		if ( pRecord == m_records.end() )
+		{
+			return;
+		}
+
+		Measure( &pRecord->second );
+	}
+
+	CheckBudget();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	pObject		Object to check
+
+bool MemoryTracker::IsTracked( void const * pObject ) const
+{
+	Lock	lock( m_pMutex );
+
+	return m_records.find( pObject ) != m_records.end();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	pSnapshot	Where to store the snapshot
+
+void MemoryTracker::GetSnapshot( Snapshot * pSnapshot ) const
+{
+	assert( pSnapshot != 0 );
+
+	pSnapshot->time					= SDL_GetTicks();
+	pSnapshot->surfaceBytes			= 0;
+	pSnapshot->animationGroupBytes	= 0;
+	pSnapshot->totalBytes			= 0;
+	pSnapshot->records.clear();
+
+	Lock	lock( m_pMutex );
+
+	pSnapshot->records.reserve( m_records.size() );
+
+	for ( RecordMap::const_iterator i = m_records.begin(); i != m_records.end(); ++i )
+	{
+		Record const &	record	= i->second;
+
+		if ( record.type == TYPE_SURFACE )
+		{
+			pSnapshot->surfaceBytes += record.bytes;
+		}
+		else
+		{
+			pSnapshot->animationGroupBytes += record.bytes;
+		}
+		pSnapshot->totalBytes += record.bytes;
+
+		pSnapshot->records.push_back( record );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+size_t MemoryTracker::GetTotalBytes() const
+{
+	Lock	lock( m_pMutex );
+
+	size_t	total	= 0;
+
+	for ( RecordMap::const_iterator i = m_records.begin(); i != m_records.end(); ++i )
+	{
+		total += i->second.bytes;
+	}
+
+	return total;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	source		Name of the file
+
+size_t MemoryTracker::GetBytesBySource( char const * source ) const
+{
+	assert( source != 0 );
+
+	Lock	lock( m_pMutex );
+
+	size_t	total	= 0;
+
+	for ( RecordMap::const_iterator i = m_records.begin(); i != m_records.end(); ++i )
+	{
+		if ( i->second.source == source )
+		{
+			total += i->second.bytes;
+		}
+	}
+
+	return total;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The budget is checked whenever an object is registered. If the total exceeds the budget, the callback is called.
+//!
+//! @param	budget		Maximum number of bytes (0 means no budget)
+//! @param	pCB			Called when the budget is exceeded (optional)
+
+void MemoryTracker::SetBudget( size_t budget, BudgetCallback pCB/* = 0*/ )
+{
+	Lock	lock( m_pMutex );
+
+	m_budget	= budget;
+	m_pBudgetCB	= pCB;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+bool MemoryTracker::IsOverBudget() const
+{
+	size_t	budget;
+
+	{
+		Lock	lock( m_pMutex );
+
+		budget = m_budget;
+	}
+
+	return budget > 0 && GetTotalBytes() > budget;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	interval	Time between reports (in milliseconds). If 0, periodic reports are disabled.
+//! @param	pCB			Called to issue the report. If 0, the report is written to stdout.
+//!
+//! @note	Reports are only issued by Service(), so Service() must be called periodically (for example, from the
+//!			idle callback of EventLoop()).
+
+void MemoryTracker::SetReportInterval( Uint32 interval, ReportCallback pCB/* = 0*/ )
+{
+	Lock	lock( m_pMutex );
+
+	m_reportInterval	= interval;
+	m_nextReport		= SDL_GetTicks() + interval;
+	m_pReportCB			= pCB;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void MemoryTracker::Service()
+{
+	ReportCallback	pCB;
+
+	{
+		Lock	lock( m_pMutex );
+
+		Uint32	now	= SDL_GetTicks();
+
+		if ( m_reportInterval == 0 || Sint32( now - m_nextReport ) < 0 )
+		{
+			return;
+		}
+
+		m_nextReport	= now + m_reportInterval;
+		pCB				= m_pReportCB;
+	}
+
+	Snapshot	snapshot;
+
+	GetSnapshot( &snapshot );
+
+	if ( pCB != 0 )
+	{
+		(*pCB)( snapshot );
+	}
+	else
+	{
+		Report( snapshot );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	fp		File to write the report to
+
+void MemoryTracker::Report( FILE * fp/* = stdout*/ ) const
+{
+	Snapshot	snapshot;
+
+	GetSnapshot( &snapshot );
+	Report( snapshot, fp );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	snapshot	Snapshot to report
+//! @param	fp			File to write the report to
+
+void MemoryTracker::Report( Snapshot const & snapshot, FILE * fp/* = stdout*/ )
+{
+	assert( fp != 0 );
+
+	fprintf( fp, "Sdlx memory report at %u ms: %lu bytes total, %lu in surfaces, %lu in animation groups\n",
+			 snapshot.time,
+			 (unsigned long)snapshot.totalBytes,
+			 (unsigned long)snapshot.surfaceBytes,
+			 (unsigned long)snapshot.animationGroupBytes );
+
+	for ( RecordList::const_iterator i = snapshot.records.begin(); i != snapshot.records.end(); ++i )
+	{
+		char const *	source	= i->source.empty() ? "(none)" : i->source.c_str();
+
+		if ( i->type == TYPE_SURFACE )
+		{
+			fprintf( fp, "    surface   %10lu bytes  %4dx%-4d %2d bpp %08x/%08x/%08x/%08x%s%s%s  %s\n",
+					 (unsigned long)i->bytes,
+					 i->w, i->h,
+					 i->bitsPerPixel,
+					 (unsigned)i->rMask, (unsigned)i->gMask, (unsigned)i->bMask, (unsigned)i->aMask,
+					 i->paletted ? "  palette" : "",
+					 i->colorKeyed ? "  colorkey" : "",
+					 i->rle ? "  rle" : "",
+					 source );
+		}
+		else
+		{
+			fprintf( fp, "    animation %10lu bytes  %d images, %d animations  %s\n",
+					 (unsigned long)i->bytes,
+					 i->imageCount,
+					 i->animationCount,
+					 source );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void MemoryTracker::Add( Type type, void const * pObject, char const * source )
+{
+	// The object is measured now because it may be destroyed without being unregistered
+
+	Record	record;
+
+	record.type		= type;
+	record.pObject	= pObject;
+	record.source	= ( source != 0 ) ? source : "";
+
+	Measure( &record );
+
+	{
+		Lock	lock( m_pMutex );
+
+		m_records[ pObject ] = record;
+	}
+
+	CheckBudget();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void MemoryTracker::CheckBudget()
+{
+	size_t			budget;
+	BudgetCallback	pCB;
+
+	{
+		Lock	lock( m_pMutex );
+
+		budget	= m_budget;
+		pCB		= m_pBudgetCB;
+	}
+
+	if ( budget == 0 || pCB == 0 )
+	{
+		return;
+	}
+
+	size_t	total	= GetTotalBytes();
+
+	if ( total > budget )
+	{
+		(*pCB)( total, budget );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void MemoryTracker::Measure( Record * pRecord )
+{
+	pRecord->w				= 0;
+	pRecord->h				= 0;
+	pRecord->bitsPerPixel	= 0;
+	pRecord->rMask			= 0;
+	pRecord->gMask			= 0;
+	pRecord->bMask			= 0;
+	pRecord->aMask			= 0;
+	pRecord->paletted		= false;
+	pRecord->colorKeyed		= false;
+	pRecord->rle			= false;
+	pRecord->imageCount		= 0;
+	pRecord->animationCount	= 0;
+
+	if ( pRecord->type == TYPE_SURFACE )
+	{
+		SDL_Surface const *	surface	= static_cast< SDL_Surface const * >( pRecord->pObject );
+
+		pRecord->bytes			= SurfaceBytes( surface );
+		pRecord->w				= surface->w;
+		pRecord->h				= surface->h;
+		pRecord->bitsPerPixel	= surface->format->BitsPerPixel;
+		pRecord->rMask			= surface->format->Rmask;
+		pRecord->gMask			= surface->format->Gmask;
+		pRecord->bMask			= surface->format->Bmask;
+		pRecord->aMask			= surface->format->Amask;
+		pRecord->paletted		= surface->format->palette != 0;
+		pRecord->colorKeyed		= ( surface->flags & SDL_SRCCOLORKEY ) != 0;
+		pRecord->rle			= ( surface->flags & SDL_RLEACCEL ) != 0;
+	}
+	else
+	{
+		AnimatedSprite::AnimationGroup const *	group	= static_cast< AnimatedSprite::AnimationGroup const * >( pRecord->pObject );
+
+		pRecord->bytes			= AnimationGroupBytes( group );
+		pRecord->imageCount		= int( group->images.size() );
+		pRecord->animationCount	= int( group->animations.size() );
+	}
+}
+
+
+} // namespace Sdlx
@@ -0,0 +1,165 @@
+/** @file *//********************************************************************************************************
+
+                                                    MemoryTracker.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/MemoryTracker.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include "Sprite.h"
+
+#include <SDL.h>
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! Tracks the memory used by surfaces and animation groups
+//
+//! Every surface created by LoadImage() and LoadColorKeyedImage() is registered automatically. Animation groups
+//! are registered explicitly with AddAnimationGroup(). An object is measured when it is registered and the tracker
+//! never accesses it again unless Refresh() is called, so changes to an object after it is registered (such as
+//! applying a color key) are only reflected after calling Refresh().
+//!
+//! @note	Surfaces registered with the tracker should be freed with FreeImage(), and animation groups should be
+//!			removed with Remove() before they are destroyed. Otherwise, the tracker will continue to report them.
+//! @note	The tracker is thread-safe.
+
+class MemoryTracker
+{
+public:
+
+	//! The type of a tracked object
+	enum Type
+	{
+		TYPE_SURFACE,				//!< An SDL_Surface
+		TYPE_ANIMATION_GROUP		//!< An AnimatedSprite::AnimationGroup
+	};
+
+	//! Information about a tracked object
+	struct Record
+	{
+		Type			type;			//!< Type of the object
+		void const *	pObject;		//!< The object
+		std::string		source;			//!< Name of the file that the object was loaded from (if any)
+		size_t			bytes;			//!< Approximate number of bytes used by the object
+		int				w, h;			//!< Surface only: dimensions of the surface
+		int				bitsPerPixel;	//!< Surface only: bits per pixel
+		Uint32			rMask;			//!< Surface only: red mask of the pixel format
+		Uint32			gMask;			//!< Surface only: green mask of the pixel format
+		Uint32			bMask;			//!< Surface only: blue mask of the pixel format
+		Uint32			aMask;			//!< Surface only: alpha mask of the pixel format
+		bool			paletted;		//!< Surface only: true if the pixel format has a palette
+		bool			colorKeyed;		//!< Surface only: true if the surface has a color key
+		bool			rle;			//!< Surface only: true if the surface is RLE-accelerated
+		int				imageCount;		//!< Animation group only: number of images
+		int				animationCount;	//!< Animation group only: number of animations
+	};
+
+	//! A vector of records
+	typedef std::vector< Record >	RecordList;
+
+	//! The state of all tracked objects at a point in time
+	struct Snapshot
+	{
+		Uint32		time;					//!< Value of SDL_GetTicks() when the snapshot was taken
+		RecordList	records;				//!< All tracked objects
+		size_t		surfaceBytes;			//!< Total bytes used by surfaces
+		size_t		animationGroupBytes;	//!< Total bytes used by animation groups
+		size_t		totalBytes;				//!< Total bytes used by all tracked objects
+	};
+
+	//! Periodic report callback.
+	typedef void (*ReportCallback)( Snapshot const & snapshot );
+
+	//! Budget exceeded callback.
+	typedef void (*BudgetCallback)( size_t totalBytes, size_t budget );
+
+	//! Returns the tracker
+	static MemoryTracker & Instance();
+
+	//! Registers a surface
+	void AddSurface( SDL_Surface const * surface, char const * source = 0 );
+
+	//! Registers an animation group
+	void AddAnimationGroup( AnimatedSprite::AnimationGroup const * group, char const * source = 0 );
+
+	//! Unregisters a surface or animation group
+	void Remove( void const * pObject );
+
+	//! Measures a registered surface or animation group again
+	void Refresh( void const * pObject );
+
+	//! Returns true if the object is registered
+	bool IsTracked( void const * pObject ) const;
+
+	//! Returns the current state of all tracked objects
+	void GetSnapshot( Snapshot * pSnapshot ) const;
+
+	//! Returns the total number of bytes used by all tracked objects
+	size_t GetTotalBytes() const;
+
+	//! Returns the total number of bytes used by objects loaded from the specified file
+	size_t GetBytesBySource( char const * source ) const;
+
+	//! Sets the memory budget (0 means no budget)
+	void SetBudget( size_t budget, BudgetCallback pCB = 0 );
+
+	//! Returns true if the total memory used exceeds the budget
+	bool IsOverBudget() const;
+
+	//! Sets the interval between periodic reports (0 disables reports)
+	void SetReportInterval( Uint32 interval, ReportCallback pCB = 0 );
+
+	//! Issues the periodic report if it is due
+	void Service();
+
+	//! Writes a report of the current state to a file
+	void Report( FILE * fp = stdout ) const;
+
+	//! Writes a report of a snapshot to a file
+	static void Report( Snapshot const & snapshot, FILE * fp = stdout );
+
+private:
+
+	typedef std::map< void const *, Record >	RecordMap;
+
+	MemoryTracker();
+	~MemoryTracker();
+
+	// Prevent copying
+	MemoryTracker( MemoryTracker const & );
+	MemoryTracker & operator =( MemoryTracker const & );
+
+	void Add( Type type, void const * pObject, char const * source );
+	void CheckBudget();
+
+	static void Measure( Record * pRecord );
+
+	SDL_mutex *		m_pMutex;			// Guards the records
+	RecordMap		m_records;			// Measurements of all registered objects
+	size_t			m_budget;			// Memory budget (0 means no budget)
+	BudgetCallback	m_pBudgetCB;		// Called when the budget is exceeded
+	Uint32			m_reportInterval;	// Time between periodic reports (in ms)
+	Uint32			m_nextReport;		// Time of the next periodic report (in ms)
+	ReportCallback	m_pReportCB;		// Called to issue the periodic report
+};
+
+
+} // namespace Sdlx
@@ -0,0 +1,535 @@
+/** @file *//********************************************************************************************************
+
+                                                  ParticleEmitter.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/ParticleEmitter.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "ParticleEmitter.h"
+
+#include "Simd.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+	int const	IMAGE_TABLE_SIZE	= 64;	// Number of steps in a particle's life for selecting its image
+
+
+	// Returns n rounded up to a multiple of 4, so that the arrays can be processed 4 elements at a time
+
+	int RoundUp4( int n )
+	{
+		return ( n + 3 ) & ~3;
+	}
+
+
+	// Returns a pointer to a row of a 32-bit surface
+
+	inline Uint32 * Row( SDL_Surface const * surface, int y )
+	{
+		return reinterpret_cast< Uint32 * >( static_cast< Uint8 * >( surface->pixels ) + y * surface->pitch );
+	}
+
+
+} // anonymous namespace
+
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	sheet			SDL_Surface containing the particle images
+//! @param	animations		Animation group containing the particle animation
+//! @param	animation		Index of the animation played over the life of each particle
+//! @param	parameters		Parameters controlling the creation and motion of particles
+//! @param	maxParticles	Maximum number of live particles
+//! @param	x,y				Initial location of the emitter
+//!
+//! @note	Every emitter's random number generator starts with the same seed, so emitters with the same parameters
+//!			create identical particles. Use SetSeed() to make them differ.
+
+ParticleEmitter::ParticleEmitter( SDL_Surface *								sheet,
+								  AnimatedSprite::AnimationGroup const *	animations,
+								  int										animation,
+								  Parameters const &						parameters,
+								  int										maxParticles,
+								  float										x/* = 0*/,
+								  float										y/* = 0*/ )
+	:	m_parameters( parameters ),
+		m_x( x ),
+		m_y( y ),
+		m_sheet( sheet ),
+		m_pAnimations( animations ),
+		m_imageTable( IMAGE_TABLE_SIZE ),
+		m_maxParticles( maxParticles ),
+		m_count( 0 ),
+		m_emitting( true ),
+		m_pending( 0.0f ),
+		m_seed( 1 ),
+		m_hasSpans( false ),
+		m_px( RoundUp4( maxParticles ) ),
+		m_py( RoundUp4( maxParticles ) ),
+		m_vx( RoundUp4( maxParticles ) ),
+		m_vy( RoundUp4( maxParticles ) ),
+		m_life( RoundUp4( maxParticles ) ),
+		m_lifeRate( RoundUp4( maxParticles ) )
+{
+	assert( sheet != 0 );
+	assert( animations != 0 );
+	assert( animation >= 0 && animation < int( animations->animations.size() ) );
+	assert( !animations->animations[ animation ].frames.empty() );
+	assert( maxParticles > 0 );
+
+	// Build the table of images for each step of a particle's life by stretching the animation over the life
+
+	AnimatedSprite::Animation::FrameList const &	frames		= animations->animations[ animation ].frames;	// Convenience
+	float											duration	= 0.0f;
+
+	for ( AnimatedSprite::Animation::FrameList::const_iterator i = frames.begin(); i != frames.end(); ++i )
+	{
+		duration += i->time;
+	}
+
+	int		frame	= 0;
+	float	end		= frames[ 0 ].time;
+
+	for ( int i = 0; i < IMAGE_TABLE_SIZE; ++i )
+	{
+		float	t	= duration * i / IMAGE_TABLE_SIZE;
+
+		while ( t >= end && frame < int( frames.size() ) - 1 )
+		{
+			++frame;
+			end += frames[ frame ].time;
+		}
+
+		m_imageTable[ i ] = Uint16( frames[ frame ].index );
+	}
+
+	BuildSpans();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+ParticleEmitter::~ParticleEmitter()
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function creates particles at the emitter's location. If there is not enough room for all of them, only
+//! as many as will fit are created.
+//!
+//! @param	count	Number of particles to create (must be >= 0)
+
+void ParticleEmitter::Emit( int count )
+{
+	assert( count >= 0 );
+
+	count = std::max( std::min( count, m_maxParticles - m_count ), 0 );
+
+	for ( int i = m_count; i < m_count + count; ++i )
+	{
+		float	angle	= Random( m_parameters.minAngle, m_parameters.maxAngle );
+		float	speed	= Random( m_parameters.minSpeed, m_parameters.maxSpeed );
+
+		m_px[i]			= m_x;
+		m_py[i]			= m_y;
+		m_vx[i]			= speed * cosf( angle );
+		m_vy[i]			= speed * sinf( angle );
+		m_life[i]		= 0.0f;
+		m_lifeRate[i]	= 1.0f / std::max( Random( m_parameters.minLifetime, m_parameters.maxLifetime ), 0.001f );
+	}
+
+	m_count += count;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	elapsed		elapsed time (must be >= 0)
+
+void ParticleEmitter::Update( float elapsed )
+{
+	assert( elapsed >= 0.0f );
+
+	Integrate( elapsed );
+	Expire();
+
+	if ( m_emitting )
+	{
+		m_pending += m_parameters.rate * elapsed;
+
+		int	count	= int( m_pending );
+
+		m_pending -= float( count );
+		Emit( count );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! If the destination has the same format as the sheet and the images can be drawn directly, the destination is
+//! locked once and the opaque runs of each particle's image are copied into it. Otherwise, each particle is drawn
+//! with SDL_LowerBlit.
+//!
+//! @param	dst		destination surface
+
+void ParticleEmitter::Draw( SDL_Surface * dst ) const
+{
+	if ( CanDrawDirect( dst ) )
+	{
+		DrawDirect( dst );
+	}
+	else
+	{
+		DrawBlits( dst );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Returns a pseudo-random number in the range [min, max) using a linear congruential generator
+
+float ParticleEmitter::Random( float min, float max )
+{
+	m_seed = m_seed * 1664525 + 1013904223;
+
+	return min + ( max - min ) * float( m_seed >> 8 ) * ( 1.0f / 16777216.0f );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Updates the velocity, location, and life of every particle. The arrays are padded to a multiple of 4, so the
+// SSE2 version can process the padding along with the live particles.
+
+void ParticleEmitter::Integrate( float elapsed )
+{
+	float	dvx	= m_parameters.accelerationX * elapsed;
+	float	dvy	= m_parameters.accelerationY * elapsed;
+
+	float *			px			= &m_px[0];
+	float *			py			= &m_py[0];
+	float *			vx			= &m_vx[0];
+	float *			vy			= &m_vy[0];
+	float *			life		= &m_life[0];
+	float const *	lifeRate	= &m_lifeRate[0];
+
+#if defined( SDLX_USE_SSE2 )
+
+	__m128 const	t	= _mm_set1_ps( elapsed );
+	__m128 const	ax	= _mm_set1_ps( dvx );
+	__m128 const	ay	= _mm_set1_ps( dvy );
+
+	for ( int i = 0; i < m_count; i += 4 )
+	{
+		__m128	x	= _mm_add_ps( _mm_loadu_ps( vx + i ), ax );
+		__m128	y	= _mm_add_ps( _mm_loadu_ps( vy + i ), ay );
+
+		_mm_storeu_ps( vx + i, x );
+		_mm_storeu_ps( vy + i, y );
+		_mm_storeu_ps( px + i, _mm_add_ps( _mm_loadu_ps( px + i ), _mm_mul_ps( x, t ) ) );
+		_mm_storeu_ps( py + i, _mm_add_ps( _mm_loadu_ps( py + i ), _mm_mul_ps( y, t ) ) );
+		_mm_storeu_ps( life + i, _mm_add_ps( _mm_loadu_ps( life + i ), _mm_mul_ps( _mm_loadu_ps( lifeRate + i ), t ) ) );
+	}
+
+#else // defined( SDLX_USE_SSE2 )
+
+	for ( int i = 0; i < m_count; ++i )
+	{
+		vx[i]	+= dvx;
+		vy[i]	+= dvy;
+		px[i]	+= vx[i] * elapsed;
+		py[i]	+= vy[i] * elapsed;
+		life[i]	+= lifeRate[i] * elapsed;
+	}
+
+#endif // defined( SDLX_USE_SSE2 )
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Removes the particles that have expired by replacing each one with the last particle
+
+void ParticleEmitter::Expire()
+{
+	int	i	= 0;
+
+	while ( i < m_count )
+	{
+		if ( m_life[i] >= 1.0f )
+		{
+			int	last	= --m_count;
+
+			m_px[i]			= m_px[ last ];
+			m_py[i]			= m_py[ last ];
+			m_vx[i]			= m_vx[ last ];
+			m_vy[i]			= m_vy[ last ];
+			m_life[i]		= m_life[ last ];
+			m_lifeRate[i]	= m_lifeRate[ last ];
+		}
+		else
+		{
+			++i;
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Copies the opaque runs of the images used by the particles from the sheet, so that they can be drawn without
+// SDL_LowerBlit. This is only done if the sheet is 32 bits per pixel and is not alpha-blended, so that drawing a
+// run is a copy. Pixels matching the sheet's color key (if any) are not part of any run.
+
+void ParticleEmitter::BuildSpans()
+{
+	SDL_PixelFormat const *	format	= m_sheet->format;	// Convenience
+
+	if ( format->BytesPerPixel != 4 || ( m_sheet->flags & SDL_SRCALPHA ) != 0 )
+	{
+		return;
+	}
+
+	typedef AnimatedSprite::AnimationGroup	AnimationGroup;
+
+	AnimationGroup::ImageList const &	images		= m_pAnimations->images;	// Convenience
+	bool								keyed		= ( m_sheet->flags & SDL_SRCCOLORKEY ) != 0;
+	Uint32								rgbMask		= ~format->Amask;
+	Uint32								key			= format->colorkey & rgbMask;
+	SpanRange							none		= { 0, 0 };
+
+	m_imageSpans.assign( images.size(), none );
+
+	// The sheet must be locked to read its pixels because it may be RLE-encoded
+
+	if ( SDL_MUSTLOCK( m_sheet ) )
+	{
+		SDL_LockSurface( m_sheet );
+	}
+
+	std::vector< bool >	done( images.size(), false );
+
+	for ( ImageTable::const_iterator i = m_imageTable.begin(); i != m_imageTable.end(); ++i )
+	{
+		if ( done[ *i ] )
+		{
+			continue;
+		}
+		done[ *i ] = true;
+
+		SDL_Rect const &	rect	= images[ *i ].rect;	// Convenience
+		int					left	= std::max( int( rect.x ), 0 );
+		int					top		= std::max( int( rect.y ), 0 );
+		int					right	= std::min( rect.x + rect.w, m_sheet->w );
+		int					bottom	= std::min( rect.y + rect.h, m_sheet->h );
+
+		m_imageSpans[ *i ].first = int( m_spans.size() );
+
+		for ( int y = top; y < bottom; ++y )
+		{
+			Uint32 const *	pRow	= Row( m_sheet, y );
+			int				x		= left;
+
+			while ( x < right )
+			{
+				while ( x < right && keyed && ( pRow[x] & rgbMask ) == key )
+				{
+					++x;
+				}
+
+				int	start	= x;
+
+				while ( x < right && !( keyed && ( pRow[x] & rgbMask ) == key ) )
+				{
+					++x;
+				}
+
+				if ( x > start )
+				{
+					Span	span;
+
+					span.x		= Sint16( start - rect.x );
+					span.y		= Sint16( y - rect.y );
+					span.length	= Uint16( x - start );
+					span.pixels	= Uint32( m_pixels.size() );
+
+					m_spans.push_back( span );
+					m_pixels.insert( m_pixels.end(), pRow + start, pRow + x );
+				}
+			}
+		}
+
+		m_imageSpans[ *i ].end = int( m_spans.size() );
+	}
+
+	if ( SDL_MUSTLOCK( m_sheet ) )
+	{
+		SDL_UnlockSurface( m_sheet );
+	}
+
+	m_hasSpans = true;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Returns true if the particles can be drawn to the destination by copying their runs
+
+bool ParticleEmitter::CanDrawDirect( SDL_Surface const * dst ) const
+{
+	SDL_PixelFormat const *	format	= m_sheet->format;	// Convenience
+
+	return	m_hasSpans &&
+			dst->format->BytesPerPixel == 4 &&
+			dst->format->Rmask == format->Rmask &&
+			dst->format->Gmask == format->Gmask &&
+			dst->format->Bmask == format->Bmask &&
+			dst->format->Amask == format->Amask;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Draws every particle by copying the runs of its image into the destination, which is locked once for all
+// particles
+
+void ParticleEmitter::DrawDirect( SDL_Surface * dst ) const
+{
+	typedef AnimatedSprite::AnimationGroup	AnimationGroup;
+
+	SDL_Rect const &	clip	= dst->clip_rect;	// Convenience
+
+	int	clipRight	= clip.x + clip.w;
+	int	clipBottom	= clip.y + clip.h;
+
+	if ( SDL_MUSTLOCK( dst ) )
+	{
+		SDL_LockSurface( dst );
+	}
+
+	for ( int i = 0; i < m_count; ++i )
+	{
+		int								step	= std::min( int( m_life[i] * IMAGE_TABLE_SIZE ), IMAGE_TABLE_SIZE - 1 );
+		int								index	= m_imageTable[ step ];
+		AnimationGroup::Image const &	image	= m_pAnimations->images[ index ];
+		SpanRange const &				range	= m_imageSpans[ index ];
+
+		int	x	= int( m_px[i] + 0.5f ) - image.offsetX;
+		int	y	= int( m_py[i] + 0.5f ) - image.offsetY;
+
+		// Skip particles that are entirely outside of the clip rect
+
+		if ( x >= clipRight || y >= clipBottom || x + image.rect.w <= clip.x || y + image.rect.h <= clip.y )
+		{
+			continue;
+		}
+
+		for ( int j = range.first; j < range.end; ++j )
+		{
+			Span const &	span	= m_spans[j];
+			int				row		= y + span.y;
+			int				spanX	= x + span.x;
+			int				start	= std::max( spanX, int( clip.x ) );
+			int				end		= std::min( spanX + span.length, clipRight );
+
+			if ( row < clip.y || row >= clipBottom || start >= end )
+			{
+				continue;
+			}
+
+			memcpy( Row( dst, row ) + start, &m_pixels[ span.pixels + start - spanX ], ( end - start ) * sizeof( Uint32 ) );
+		}
+	}
+
+	if ( SDL_MUSTLOCK( dst ) )
+	{
+		SDL_UnlockSurface( dst );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Draws each particle with SDL_LowerBlit after clipping it, which avoids the validation and clipping done by
+// SDL_BlitSurface for each particle
+
+void ParticleEmitter::DrawBlits( SDL_Surface * dst ) const
+{
+	typedef AnimatedSprite::AnimationGroup	AnimationGroup;
+
+	AnimationGroup::ImageList const &	images	= m_pAnimations->images;	// Convenience
+	SDL_Rect const &					clip	= dst->clip_rect;			// Convenience
+
+	int	clipRight	= clip.x + clip.w;
+	int	clipBottom	= clip.y + clip.h;
+
+	for ( int i = 0; i < m_count; ++i )
+	{
+		int								step	= std::min( int( m_life[i] * IMAGE_TABLE_SIZE ), IMAGE_TABLE_SIZE - 1 );
+		AnimationGroup::Image const &	image	= images[ m_imageTable[ step ] ];
+
+		int	x		= int( m_px[i] + 0.5f ) - image.offsetX;
+		int	y		= int( m_py[i] + 0.5f ) - image.offsetY;
+		int	left	= std::max( x, int( clip.x ) );
+		int	top		= std::max( y, int( clip.y ) );
+		int	right	= std::min( x + image.rect.w, clipRight );
+		int	bottom	= std::min( y + image.rect.h, clipBottom );
+
+		if ( left >= right || top >= bottom )
+		{
+			continue;
+		}
+
+		SDL_Rect	source		= MakeRect( image.rect.x + left - x, image.rect.y + top - y, right - left, bottom - top );
+		SDL_Rect	position	= MakeRect( left, top, right - left, bottom - top );
+
+		SDL_LowerBlit( m_sheet, &source, dst, &position );
+	}
+}
+
+
+} // namespace Sdlx
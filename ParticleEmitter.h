@@ -0,0 +1,160 @@
+/** @file *//********************************************************************************************************
+
+                                                   ParticleEmitter.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/ParticleEmitter.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include "Sprite.h"
+
+#include <SDL.h>
+
+#include <vector>
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! A particle emitter
+//
+//! An emitter creates particles at its location and moves them until they expire. Each particle is drawn with an
+//! image from an animation in an animation group. The animation is played once over the particle's lifetime, so the
+//! particle's image depends on its age relative to its lifetime rather than on the frame durations.
+//!
+//! The particles are stored as a structure of arrays with a fixed capacity, so no memory is allocated after the
+//! emitter is created, and the particles are updated in a single pass over each array (4 at a time if SSE2 is
+//! available).
+//!
+//! If the sheet is 32 bits per pixel without per-pixel or per-surface alpha, the opaque (non-color-keyed) pixels of
+//! the particle images are copied from the sheet into runs when the emitter is created. If the destination has the
+//! same format, it is locked once and the runs are copied directly into it. Otherwise, each particle is drawn with
+//! SDL_LowerBlit after being clipped by the emitter.
+//!
+//! @note	The emitter does not assume ownership of the sheet or the animation group.
+//! @note	Changes to the sheet's pixels after the emitter is created are not reflected when drawing directly.
+
+class ParticleEmitter
+{
+public:
+
+	//! Parameters controlling the creation and motion of particles
+	struct Parameters
+	{
+		float	rate;						//!< Particles created per second
+		float	minLifetime, maxLifetime;	//!< Range of the lifetime of a particle (in seconds)
+		float	minSpeed, maxSpeed;			//!< Range of the initial speed of a particle (in pixels per second)
+		float	minAngle, maxAngle;			//!< Range of the initial direction of a particle (in radians)
+		float	accelerationX;				//!< Acceleration of every particle (in pixels per second squared)
+		float	accelerationY;				//!< Acceleration of every particle (in pixels per second squared)
+	};
+
+	//! Constructor
+	ParticleEmitter( SDL_Surface *							sheet,
+					 AnimatedSprite::AnimationGroup const *	animations,
+					 int									animation,
+					 Parameters const &						parameters,
+					 int									maxParticles,
+					 float									x = 0,
+					 float									y = 0 );
+
+	// Destructor
+	virtual ~ParticleEmitter();
+
+	//! Creates particles immediately
+	void Emit( int count );
+
+	//! Advances the time (in seconds), creating, moving, and expiring particles
+	void Update( float elapsed );
+
+	//! Draws all particles
+	void Draw( SDL_Surface * dst ) const;
+
+	//! Removes all particles
+	void Clear()									{ m_count = 0; }
+
+	//! Turns the continuous creation of particles on or off
+	void SetEmitting( bool emitting )				{ m_emitting = emitting; }
+
+	//! Returns true if particles are created continuously
+	bool IsEmitting() const							{ return m_emitting; }
+
+	//! Returns the number of live particles
+	int GetCount() const							{ return m_count; }
+
+	//! Seeds the random number generator used to create particles
+	void SetSeed( Uint32 seed )						{ m_seed = seed; }
+
+	Parameters	m_parameters;	//!< Parameters controlling the creation and motion of particles
+	float		m_x;			//!< Location of the emitter
+	float		m_y;			//!< Location of the emitter
+
+private:
+
+	// A run of opaque pixels in a row of a particle image
+	struct Span
+	{
+		Sint16	x, y;		// Location of the first pixel relative to the UL corner of the image
+		Uint16	length;		// Number of pixels
+		Uint32	pixels;		// Index of the first pixel in m_pixels
+	};
+
+	// The range of spans of an image
+	struct SpanRange
+	{
+		int		first;		// Index of the first span
+		int		end;		// Index of the span after the last span
+	};
+
+	typedef std::vector< float >		FloatList;
+	typedef std::vector< Uint16 >		ImageTable;
+	typedef std::vector< Span >			SpanList;
+	typedef std::vector< SpanRange >	SpanRangeList;
+	typedef std::vector< Uint32 >		PixelList;
+
+	// Prevent copying
+	ParticleEmitter( ParticleEmitter const & );
+	ParticleEmitter & operator =( ParticleEmitter const & );
+
+	float Random( float min, float max );
+	void Integrate( float elapsed );
+	void Expire();
+	void BuildSpans();
+	bool CanDrawDirect( SDL_Surface const * dst ) const;
+	void DrawDirect( SDL_Surface * dst ) const;
+	void DrawBlits( SDL_Surface * dst ) const;
+
+	SDL_Surface *							m_sheet;			// The sheet containing the particle images
+	AnimatedSprite::AnimationGroup const *	m_pAnimations;		// The animation group
+	ImageTable								m_imageTable;		// Image index for each step of a particle's life
+	int										m_maxParticles;		// Capacity of the particle arrays
+	int										m_count;			// Number of live particles
+	bool									m_emitting;			// True if particles are created continuously
+	float									m_pending;			// Fractional particles not created yet
+	Uint32									m_seed;				// Random number generator state
+	bool									m_hasSpans;			// True if the images can be drawn directly
+	SpanList								m_spans;			// Opaque runs of the particle images
+	SpanRangeList							m_imageSpans;		// Spans of each image in the animation group
+	PixelList								m_pixels;			// Pixels of the spans
+
+	FloatList								m_px;				// Particle locations
+	FloatList								m_py;				// Particle locations
+	FloatList								m_vx;				// Particle velocities
+	FloatList								m_vy;				// Particle velocities
+	FloatList								m_life;				// Fraction of each particle's lifetime that has passed
+	FloatList								m_lifeRate;			// 1 / lifetime of each particle
+};
+
+
+} // namespace Sdlx
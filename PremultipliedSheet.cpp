@@ -0,0 +1,521 @@
+/** @file *//********************************************************************************************************
+
+                                                PremultipliedSheet.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/PremultipliedSheet.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "PremultipliedSheet.h"
+
+#include "MemoryTracker.h"
+#include "Sdlx.h"
+#include "Simd.h"
+
+#include <cstring>
+
+namespace
+{
+
+	// Returns x / 255 (rounded) for 0 <= x <= 255 * 255
+
+	inline Uint32 DivideBy255( Uint32 x )
+	{
+		x += 128;
+		return ( x + ( x >> 8 ) ) >> 8;
+	}
+
+
+	// Returns the pixel with its colors multiplied by its alpha
+
+	inline Uint32 Premultiply( Uint32 pixel, int ashift )
+	{
+		Uint32	a		= ( pixel >> ashift ) & 0xff;
+		Uint32	result	= a << ashift;
+
+		for ( int shift = 0; shift < 32; shift += 8 )
+		{
+			if ( shift != ashift )
+			{
+				result |= DivideBy255( ( ( pixel >> shift ) & 0xff ) * a ) << shift;
+			}
+		}
+
+		return result;
+	}
+
+
+	// Blends premultiplied pixels over the destination: d = s + d * ( 1 - s.alpha ). Two channels are blended at
+	// once in each 32-bit multiply.
+
+	void BlendScalar( Uint32 * pDst, Uint32 const * pSrc, int n, int ashift )
+	{
+		for ( int i = 0; i < n; ++i )
+		{
+			Uint32	s	= pSrc[i];
+			Uint32	d	= pDst[i];
+			Uint32	inv	= 255 - ( ( s >> ashift ) & 0xff );
+
+			Uint32	rb	= ( d & 0x00ff00ff ) * inv + 0x00800080;
+			Uint32	ag	= ( ( d >> 8 ) & 0x00ff00ff ) * inv + 0x00800080;
+
+			rb = ( ( rb + ( ( rb >> 8 ) & 0x00ff00ff ) ) >> 8 ) & 0x00ff00ff;
+			ag = ( ag + ( ( ag >> 8 ) & 0x00ff00ff ) ) & 0xff00ff00;
+
+			pDst[i] = s + rb + ag;
+		}
+	}
+
+
+#if defined( SDLX_USE_SSE2 )
+
+	// Blends premultiplied pixels over the destination 4 pixels at a time. The alpha must be in the high byte.
+
+	void BlendSse2( Uint32 * pDst, Uint32 const * pSrc, int n )
+	{
+		__m128i const	zero	= _mm_setzero_si128();
+		__m128i const	k255	= _mm_set1_epi16( 255 );
+		__m128i const	k128	= _mm_set1_epi16( 128 );
+
+		for ( ; n >= 4; n -= 4, pSrc += 4, pDst += 4 )
+		{
+			__m128i	s	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pSrc ) );
+			__m128i	d	= _mm_loadu_si128( reinterpret_cast< __m128i const * >( pDst ) );
+
+			// Expand to 16 bits per channel
+
+			__m128i	sLo	= _mm_unpacklo_epi8( s, zero );
+			__m128i	sHi	= _mm_unpackhi_epi8( s, zero );
+			__m128i	dLo	= _mm_unpacklo_epi8( d, zero );
+			__m128i	dHi	= _mm_unpackhi_epi8( d, zero );
+
+			// Broadcast 255 - alpha to all channels of each pixel
+
+			__m128i	iLo	= _mm_sub_epi16( k255, _mm_shufflehi_epi16( _mm_shufflelo_epi16( sLo, 0xff ), 0xff ) );
+			__m128i	iHi	= _mm_sub_epi16( k255, _mm_shufflehi_epi16( _mm_shufflelo_epi16( sHi, 0xff ), 0xff ) );
+
+			// d * ( 255 - alpha ) / 255 + s
+
+			dLo = _mm_add_epi16( _mm_mullo_epi16( dLo, iLo ), k128 );
+			dHi = _mm_add_epi16( _mm_mullo_epi16( dHi, iHi ), k128 );
+			dLo = _mm_srli_epi16( _mm_add_epi16( dLo, _mm_srli_epi16( dLo, 8 ) ), 8 );
+			dHi = _mm_srli_epi16( _mm_add_epi16( dHi, _mm_srli_epi16( dHi, 8 ) ), 8 );
+
+			__m128i	result	= _mm_packus_epi16( _mm_add_epi16( dLo, sLo ), _mm_add_epi16( dHi, sHi ) );
+
+			_mm_storeu_si128( reinterpret_cast< __m128i * >( pDst ), result );
+		}
+
+		BlendScalar( pDst, pSrc, n, 24 );
+	}
+
+#endif // defined( SDLX_USE_SSE2 )
+
+
+	// Blends premultiplied pixels over the destination using the fastest available method
+
+	inline void Blend( Uint32 * pDst, Uint32 const * pSrc, int n, int ashift )
+	{
+#if defined( SDLX_USE_SSE2 )
+		if ( ashift == 24 )
+		{
+			BlendSse2( pDst, pSrc, n );
+			return;
+		}
+#endif
+		BlendScalar( pDst, pSrc, n, ashift );
+	}
+
+
+	// Returns a pointer to a row of a 32-bit surface
+
+	inline Uint32 * Row( SDL_Surface * surface, int y )
+	{
+		return reinterpret_cast< Uint32 * >( static_cast< Uint8 * >( surface->pixels ) + y * surface->pitch );
+	}
+
+
+} // anonymous namespace
+
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+PremultipliedSheet::PremultipliedSheet( SDL_Surface * surface, char const * filename )
+	:	m_surface( surface )
+{
+	MemoryTracker::Instance().AddSurface( m_surface, filename );
+	BuildSpans();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+PremultipliedSheet::~PremultipliedSheet()
+{
+	FreeImage( m_surface );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function loads an image file and converts it to a 32-bit format with premultiplied alpha. If the image
+//! has no alpha channel, it is opaque (except for pixels matching its color key, if it has one). Ownership of the
+//! sheet is passed to the caller. The sheet must be deallocated using delete.
+//!
+//! @param	filename	name of the file to load
+//! @param	format		format of the surfaces the sheet will be drawn to. It must be 32 bits per pixel. If 0, the
+//!						format of the display is used.
+//!
+//! @return		the new sheet, or 0 if error
+
+PremultipliedSheet * PremultipliedSheet::Load( char const * filename, SDL_PixelFormat * format/* = 0*/ )
+{
+	SDL_Surface *	image	= LoadAlphaImage( filename, format );
+
+	if ( image == 0 )
+	{
+		return 0;
+	}
+
+	int	ashift	= image->format->Ashift;
+
+	for ( int y = 0; y < image->h; ++y )
+	{
+		Uint32 *	pRow	= Row( image, y );
+
+		for ( int x = 0; x < image->w; ++x )
+		{
+			pRow[x] = Premultiply( pRow[x], ashift );
+		}
+	}
+
+	return new PremultipliedSheet( image, filename );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function loads an image file and converts it to a 32-bit format with premultiplied alpha. Pixels matching
+//! the color key are transparent. If feathering is enabled, the pixels on the edges of the opaque regions are made
+//! partially transparent in proportion to the number of transparent pixels around them, which softens the edges.
+//! Ownership of the sheet is passed to the caller. The sheet must be deallocated using delete.
+//!
+//! @param	filename	name of the file to load
+//! @param	key			color key
+//! @param	feather		if true, the edges are softened
+//! @param	format		format of the surfaces the sheet will be drawn to. It must be 32 bits per pixel. If 0, the
+//!						format of the display is used.
+//!
+//! @return		the new sheet, or 0 if error
+
+PremultipliedSheet * PremultipliedSheet::LoadColorKeyed( char const *		filename,
+														 SDL_Color			key,
+														 bool				feather/* = true*/,
+														 SDL_PixelFormat *	format/* = 0*/ )
+{
+	SDL_Surface *	image	= LoadAlphaImage( filename, format );
+
+	if ( image == 0 )
+	{
+		return 0;
+	}
+
+	int		w			= image->w;
+	int		h			= image->h;
+	int		ashift		= image->format->Ashift;
+	Uint32	rgbMask		= image->format->Rmask | image->format->Gmask | image->format->Bmask;
+	Uint32	keyColor	= SDL_MapRGB( image->format, key.r, key.g, key.b ) & rgbMask;
+
+	// Find the pixels matching the color key
+
+	std::vector< Uint8 >	keyed( w * h );
+
+	for ( int y = 0; y < h; ++y )
+	{
+		Uint32 const *	pRow	= Row( image, y );
+
+		for ( int x = 0; x < w; ++x )
+		{
+			keyed[ y * w + x ] = ( ( pRow[x] & rgbMask ) == keyColor );
+		}
+	}
+
+	// Set the alpha of each pixel and premultiply
+
+	for ( int y = 0; y < h; ++y )
+	{
+		Uint32 *	pRow	= Row( image, y );
+
+		for ( int x = 0; x < w; ++x )
+		{
+			if ( keyed[ y * w + x ] )
+			{
+				pRow[x] = 0;
+				continue;
+			}
+
+			Uint32	alpha	= ( pRow[x] >> ashift ) & 0xff;
+
+			if ( feather )
+			{
+				// Scale the alpha by the fraction of the 3x3 neighborhood that is not transparent. Pixels outside
+				// the image are considered to be opaque.
+
+				int	count	= 0;
+
+				for ( int j = std::max( y - 1, 0 ); j <= std::min( y + 1, h - 1 ); ++j )
+				{
+					for ( int i = std::max( x - 1, 0 ); i <= std::min( x + 1, w - 1 ); ++i )
+					{
+						count += keyed[ j * w + i ];
+					}
+				}
+
+				alpha = alpha * ( 9 - count ) / 9;
+			}
+
+			pRow[x] = Premultiply( ( pRow[x] & ~( 0xffu << ashift ) ) | ( alpha << ashift ), ashift );
+		}
+	}
+
+	return new PremultipliedSheet( image, filename );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function draws a region of the sheet. The region is clipped to the sheet and to the destination's clip
+//! rect.
+//!
+//! @param	src		Region of the sheet to draw, or 0 to draw the entire sheet
+//! @param	dst		Destination surface. It must be 32 bits per pixel with the same color masks as the sheet. If
+//!					not, nothing is drawn.
+//! @param	x,y		Location of the region on the destination surface
+
+void PremultipliedSheet::Blit( SDL_Rect const * src, SDL_Surface * dst, int x, int y ) const
+{
+	bool	compatible	= dst->format->BytesPerPixel == 4 &&
+						  dst->format->Rmask == m_surface->format->Rmask &&
+						  dst->format->Gmask == m_surface->format->Gmask &&
+						  dst->format->Bmask == m_surface->format->Bmask;
+
+	assert( compatible );
+	if ( !compatible )
+	{
+		return;
+	}
+
+	// Clip the region to the sheet
+
+	int	sx	= 0;
+	int	sy	= 0;
+	int	sw	= m_surface->w;
+	int	sh	= m_surface->h;
+
+	if ( src != 0 )
+	{
+		sx = std::max( int( src->x ), 0 );
+		sy = std::max( int( src->y ), 0 );
+		sw = std::min( src->x + src->w, m_surface->w ) - sx;
+		sh = std::min( src->y + src->h, m_surface->h ) - sy;
+		x += sx - src->x;
+		y += sy - src->y;
+	}
+
+	// Clip the region to the destination
+
+	SDL_Rect const &	clip	= dst->clip_rect;
+
+	if ( x < clip.x )
+	{
+		sx += clip.x - x;
+		sw -= clip.x - x;
+		x = clip.x;
+	}
+	if ( y < clip.y )
+	{
+		sy += clip.y - y;
+		sh -= clip.y - y;
+		y = clip.y;
+	}
+	sw = std::min( sw, clip.x + clip.w - x );
+	sh = std::min( sh, clip.y + clip.h - y );
+
+	if ( sw <= 0 || sh <= 0 )
+	{
+		return;
+	}
+
+	// Draw each row, one span at a time
+
+	if ( SDL_MUSTLOCK( dst ) )
+	{
+		SDL_LockSurface( dst );
+	}
+
+	int	ashift	= m_surface->format->Ashift;
+	int	right	= sx + sw;
+
+	for ( int row = 0; row < sh; ++row )
+	{
+		Uint32 const *	pSrc	= Row( m_surface, sy + row );
+		Uint32 *		pDst	= Row( dst, y + row ) + x - sx;		// Indexed by the column in the sheet
+
+		for ( int i = m_rows[ sy + row ]; i < m_rows[ sy + row + 1 ]; ++i )
+		{
+			Span const &	span	= m_spans[i];
+
+			if ( span.start >= right )
+			{
+				break;
+			}
+
+			int	start	= std::max( int( span.start ), sx );
+			int	end		= std::min( span.start + span.length, right );
+
+			if ( start >= end )
+			{
+				continue;
+			}
+
+			switch ( span.type )
+			{
+			case SPAN_OPAQUE:
+				memcpy( pDst + start, pSrc + start, ( end - start ) * sizeof( Uint32 ) );
+				break;
+
+			case SPAN_PARTIAL:
+				Blend( pDst + start, pSrc + start, end - start, ashift );
+				break;
+
+			case SPAN_TRANSPARENT:
+				break;
+			}
+		}
+	}
+
+	if ( SDL_MUSTLOCK( dst ) )
+	{
+		SDL_UnlockSurface( dst );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Loads an image into a 32-bit surface with an alpha channel. The colors are not premultiplied.
+
+SDL_Surface * PremultipliedSheet::LoadAlphaImage( char const * filename, SDL_PixelFormat * format )
+{
+	if ( format == 0 )
+	{
+		SDL_Surface *	screen	= SDL_GetVideoSurface();
+
+		if ( screen == 0 )
+		{
+			return 0;
+		}
+
+		format = screen->format;
+	}
+
+	if ( format->BitsPerPixel != 32 )
+	{
+		return 0;
+	}
+
+	SDL_Surface *	loadedImage	= IMG_Load( filename );
+
+	if ( loadedImage == 0 )
+	{
+		return 0;
+	}
+
+	// The alpha goes in whichever byte is not used by the colors
+
+	Uint32	amask	= ~( format->Rmask | format->Gmask | format->Bmask );
+
+	SDL_Surface *	image	= SDL_CreateRGBSurface( SDL_SWSURFACE, loadedImage->w, loadedImage->h, 32,
+													format->Rmask, format->Gmask, format->Bmask, amask );
+	if ( image != 0 )
+	{
+		// Copy the pixels, including the alpha channel. Pixels matching the loaded image's color key (if any) are
+		// skipped, so they remain transparent.
+
+		SDL_FillRect( image, 0, 0 );
+		SDL_SetAlpha( loadedImage, 0, SDL_ALPHA_OPAQUE );
+		SDL_BlitSurface( loadedImage, 0, image, 0 );
+	}
+
+	SDL_FreeSurface( loadedImage );
+
+	return image;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Divides each row into spans of transparent, opaque, and partially transparent pixels
+
+void PremultipliedSheet::BuildSpans()
+{
+	int	ashift	= m_surface->format->Ashift;
+
+	m_spans.clear();
+	m_rows.clear();
+	m_rows.reserve( m_surface->h + 1 );
+
+	for ( int y = 0; y < m_surface->h; ++y )
+	{
+		Uint32 const *	pRow	= Row( m_surface, y );
+
+		m_rows.push_back( int( m_spans.size() ) );
+
+		for ( int x = 0; x < m_surface->w; ++x )
+		{
+			Uint32	alpha	= ( pRow[x] >> ashift ) & 0xff;
+			Uint8	type	= ( alpha == 0 ) ? SPAN_TRANSPARENT : ( alpha == 255 ) ? SPAN_OPAQUE : SPAN_PARTIAL;
+
+			if ( m_spans.size() > size_t( m_rows.back() ) && m_spans.back().type == type )
+			{
+				++m_spans.back().length;
+			}
+			else
+			{
+				Span	span	= { Uint16( x ), 1, type };
+
+				m_spans.push_back( span );
+			}
+		}
+	}
+
+	m_rows.push_back( int( m_spans.size() ) );
+}
+
+
+} // namespace Sdlx
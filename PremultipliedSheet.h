@@ -0,0 +1,100 @@
+/** @file *//********************************************************************************************************
+
+                                                 PremultipliedSheet.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/PremultipliedSheet.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include <SDL.h>
+
+#include <vector>
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! A sheet with premultiplied alpha
+//
+//! A premultiplied sheet is a 32-bit sheet whose colors have been multiplied by their alpha, drawn with its own
+//! blending code instead of SDL's. Each row of the sheet is divided into spans of opaque, transparent, and partially
+//! transparent pixels when the sheet is loaded. When drawn, opaque spans are copied, transparent spans are skipped,
+//! and only the partially transparent pixels are blended, so a sprite with soft edges costs about the same as a
+//! color-keyed sprite.
+//!
+//! A sheet can be loaded from an image with an alpha channel, or from an image with a color key. In the latter
+//! case, the edges can be feathered to give them a soft edge.
+//!
+//! @note	The destination surface must be 32 bits per pixel with the same color masks as the sheet. Sheets are
+//!			loaded in the format of the display by default.
+
+class PremultipliedSheet
+{
+public:
+
+	// Destructor
+	virtual ~PremultipliedSheet();
+
+	//! Loads an image file with an alpha channel
+	static PremultipliedSheet * Load( char const * filename, SDL_PixelFormat * format = 0 );
+
+	//! Loads an image file and converts the color key to alpha
+	static PremultipliedSheet * LoadColorKeyed( char const *		filename,
+												SDL_Color			key,
+												bool				feather = true,
+												SDL_PixelFormat *	format = 0 );
+
+	//! Draws a region of the sheet
+	void Blit( SDL_Rect const * src, SDL_Surface * dst, int x, int y ) const;
+
+	//! Returns the sheet's surface
+	SDL_Surface * GetSurface() const				{ return m_surface; }
+
+private:
+
+	// Type of a span
+	enum SpanType
+	{
+		SPAN_TRANSPARENT,	// All pixels have alpha = 0
+		SPAN_OPAQUE,		// All pixels have alpha = 255
+		SPAN_PARTIAL		// All pixels have 0 < alpha < 255
+	};
+
+	// A run of pixels in a row with the same type
+	struct Span
+	{
+		Uint16	start;		// Column of the first pixel
+		Uint16	length;		// Number of pixels
+		Uint8	type;		// SpanType
+	};
+
+	typedef std::vector< Span >	SpanList;
+
+	// Constructor
+	PremultipliedSheet( SDL_Surface * surface, char const * filename );
+
+	// Prevent copying
+	PremultipliedSheet( PremultipliedSheet const & );
+	PremultipliedSheet & operator =( PremultipliedSheet const & );
+
+	static SDL_Surface * LoadAlphaImage( char const * filename, SDL_PixelFormat * format );
+	void BuildSpans();
+
+	SDL_Surface *		m_surface;		// The premultiplied pixels
+	SpanList			m_spans;		// The spans of all rows
+	std::vector< int >	m_rows;			// Index of the first span of each row (plus one past the last span)
+};
+
+
+} // namespace Sdlx
@@ -0,0 +1,243 @@
+/** @file *//********************************************************************************************************
+
+                                                    RenderQueue.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/RenderQueue.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "RenderQueue.h"
+
+#include "Sprite.h"
+
+namespace
+{
+
+	// If more than 1 / FULL_SORT_RATIO of the sprites are out of order, the entire list is radix-sorted instead of
+	// sorting and merging the changed sprites.
+	int const	FULL_SORT_RATIO		= 8;
+
+
+} // anonymous namespace
+
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+RenderQueue::RenderQueue()
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+RenderQueue::~RenderQueue()
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The sprite is placed in order the next time the queue is sorted.
+//!
+//! @param	pSprite		Sprite to add
+
+void RenderQueue::Add( Sprite const * pSprite )
+{
+	assert( pSprite != 0 );
+
+	Entry	entry	= { 0, pSprite };
+
+	m_changed.push_back( entry );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	pSprite		Sprite to remove. If the sprite is not in the queue, nothing happens.
+
+void RenderQueue::Remove( Sprite const * pSprite )
+{
+	for ( EntryList::iterator i = m_entries.begin(); i != m_entries.end(); ++i )
+	{
+		if ( i->pSprite == pSprite )
+		{
+			m_entries.erase( i );
+			return;
+		}
+	}
+
+	for ( EntryList::iterator i = m_changed.begin(); i != m_changed.end(); ++i )
+	{
+		if ( i->pSprite == pSprite )
+		{
+			m_changed.erase( i );
+			return;
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void RenderQueue::Clear()
+{
+	m_entries.clear();
+	m_changed.clear();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function puts the sprites in order of their current sort keys. Sprites whose keys have not changed since
+//! the last sort remain in order, so they are left in place. The sprites whose keys have changed are removed,
+//! sorted, and merged back in. If too many keys have changed, all the sprites are radix-sorted instead.
+
+void RenderQueue::Sort()
+{
+	// Update the keys of the sprites added since the last sort
+
+	for ( EntryList::iterator i = m_changed.begin(); i != m_changed.end(); ++i )
+	{
+		i->key = i->pSprite->GetSortKey();
+	}
+
+	// Update the keys, moving the sprites whose keys have changed to the changed list. The remaining sprites are
+	// still in order.
+
+	EntryList::iterator	out	= m_entries.begin();
+
+	for ( EntryList::iterator i = m_entries.begin(); i != m_entries.end(); ++i )
+	{
+		Uint32	key	= i->pSprite->GetSortKey();
+
+		if ( key == i->key )
+		{
+			*out++ = *i;
+		}
+		else
+		{
+			Entry	entry	= { key, i->pSprite };
+
+			m_changed.push_back( entry );
+		}
+	}
+
+	m_entries.erase( out, m_entries.end() );
+
+	if ( m_changed.empty() )
+	{
+		return;
+	}
+
+	// If only a few have changed, then sort them and merge them back in. Otherwise, sort everything.
+
+	int	total	= int( m_entries.size() + m_changed.size() );
+
+	if ( int( m_changed.size() ) * FULL_SORT_RATIO <= total )
+	{
+		std::sort( m_changed.begin(), m_changed.end(), IsLess );
+
+		m_scratch.resize( total );
+		std::merge( m_entries.begin(), m_entries.end(), m_changed.begin(), m_changed.end(), m_scratch.begin(), IsLess );
+		m_entries.swap( m_scratch );
+	}
+	else
+	{
+		m_entries.insert( m_entries.end(), m_changed.begin(), m_changed.end() );
+		RadixSort();
+	}
+
+	m_changed.clear();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	dst		Destination surface
+
+void RenderQueue::Draw( SDL_Surface * dst )
+{
+	Sort();
+
+	for ( EntryList::const_iterator i = m_entries.begin(); i != m_entries.end(); ++i )
+	{
+		i->pSprite->Draw( dst );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Sorts the entries with a least-significant-digit radix sort, one byte of the key at a time. A pass is skipped if
+// all the keys have the same value in that byte, which is common for the layer byte.
+
+void RenderQueue::RadixSort()
+{
+	int	n	= int( m_entries.size() );
+
+	m_scratch.resize( n );
+
+	for ( int shift = 0; shift < 32; shift += 8 )
+	{
+		int	counts[ 256 ]	= { 0 };
+
+		for ( int i = 0; i < n; ++i )
+		{
+			++counts[ ( m_entries[i].key >> shift ) & 0xff ];
+		}
+
+		if ( counts[ ( m_entries[0].key >> shift ) & 0xff ] == n )
+		{
+			continue;
+		}
+
+		int	offset	= 0;
+
+		for ( int b = 0; b < 256; ++b )
+		{
+			int	count	= counts[b];
+
+			counts[b]	= offset;
+			offset		+= count;
+		}
+
+		for ( int i = 0; i < n; ++i )
+		{
+			Entry const &	entry	= m_entries[i];
+
+			m_scratch[ counts[ ( entry.key >> shift ) & 0xff ]++ ] = entry;
+		}
+
+		m_entries.swap( m_scratch );
+	}
+}
+
+
+} // namespace Sdlx
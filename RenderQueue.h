@@ -0,0 +1,90 @@
+/** @file *//********************************************************************************************************
+
+                                                     RenderQueue.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/RenderQueue.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include <SDL.h>
+
+#include <vector>
+
+namespace Sdlx
+{
+
+class Sprite;
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! A list of sprites drawn in order of their sort keys
+//
+//! The queue keeps its sprites sorted by the keys returned by Sprite::GetSortKey(). The order is maintained
+//! incrementally: when the queue is sorted, only the sprites whose keys have changed (and sprites that have been
+//! added) are sorted and merged back into the list. If many keys have changed, the entire list is radix-sorted
+//! instead.
+//!
+//! Sprites with equal keys are drawn in an unspecified order.
+//!
+//! @note	The queue does not assume ownership of the sprites.
+
+class RenderQueue
+{
+public:
+
+	//! Constructor
+	RenderQueue();
+
+	// Destructor
+	virtual ~RenderQueue();
+
+	//! Adds a sprite
+	void Add( Sprite const * pSprite );
+
+	//! Removes a sprite
+	void Remove( Sprite const * pSprite );
+
+	//! Removes all sprites
+	void Clear();
+
+	//! Updates the order of the sprites
+	void Sort();
+
+	//! Sorts and draws all sprites
+	void Draw( SDL_Surface * dst );
+
+	//! Returns the number of sprites in the queue
+	int GetSize() const							{ return int( m_entries.size() + m_changed.size() ); }
+
+private:
+
+	// A sprite and its sort key
+	struct Entry
+	{
+		Uint32			key;		// The sprite's sort key when it was last sorted
+		Sprite const *	pSprite;	// The sprite
+	};
+
+	typedef std::vector< Entry >	EntryList;
+
+	static bool IsLess( Entry const & a, Entry const & b )		{ return a.key < b.key; }
+
+	void RadixSort();
+
+	EntryList	m_entries;		// Sprites in sorted order
+	EntryList	m_changed;		// Sprites that are not in sorted order
+	EntryList	m_scratch;		// Temporary storage used when sorting
+};
+
+
+} // namespace Sdlx
@@ -15,6 +15,8 @@
 
 #include "Sdlx.h"
 
+#include "MemoryTracker.h"
+
 namespace
 {
 
@@ -35,7 +37,7 @@ namespace Sdlx
 /*																													*/
 /********************************************************************************************************************/
 
-//! This function loads an image file and converts it to the format of the display.
+//! This function loads an image file and converts it to the format of the display, or to the specified format.
 //! All image formats supported by SDL_image can be loaded. Currently, they are:
 //!		- BMP
 //!		- JPEG
@@ -44,11 +46,15 @@ namespace Sdlx
 //!		- TGA
 //!		- and more
 //!
+//! The image is registered with the MemoryTracker, so it should be freed with FreeImage().
+//!
 //! @param	filename	name of the file to load
+//! @param	format		format to convert to. If 0, the image is converted to the format of the display, which
+//!						requires the video mode to be set.
 //!
 //! @return		pointer to the loaded file, or 0 if error
 
-SDL_Surface * LoadImage( char const * filename ) 
+SDL_Surface * LoadImage( char const * filename, SDL_PixelFormat * format/* = 0*/ ) 
 {
 	SDL_Surface *	loadedImage		= 0;
 	SDL_Surface *	image			= 0;
@@ -57,8 +63,20 @@ SDL_Surface * LoadImage( char const * filename )
 
 	if ( loadedImage != 0 )
 	{
-		image = SDL_DisplayFormat( loadedImage );	// Create an optimized image from the loaded image
-		SDL_FreeSurface( loadedImage );				// Free the old image
+		if ( format != 0 )
+		{
+			image = SDL_ConvertSurface( loadedImage, format, SDL_SWSURFACE );
+		}
+		else
+		{
+			image = SDL_DisplayFormat( loadedImage );	// Create an optimized image from the loaded image
+		}
+		SDL_FreeSurface( loadedImage );					// Free the old image
+	}
+
+	if ( image != 0 )
+	{
+		MemoryTracker::Instance().AddSurface( image, filename );
 	}
 
 	return image;
@@ -69,8 +87,8 @@ SDL_Surface * LoadImage( char const * filename )
 /*																													*/
 /********************************************************************************************************************/
 
-//! This function loads an image file and converts it to the format of the display. In addition, a color key is
-//! specified.
+//! This function loads an image file and converts it to the format of the display, or to the specified format.
+//! In addition, a color key is specified.
 //!
 //! All image formats supported by SDL_image can be loaded. Currently, they are:
 //!		- BMP
@@ -81,23 +99,45 @@ SDL_Surface * LoadImage( char const * filename )
 //!		- and more
 //!
 //! @param	filename	name of the file to load
+//! @param	key			color key
+//! @param	format		format to convert to. If 0, the image is converted to the format of the display, which
+//!						requires the video mode to be set.
 //!
 //! @return		pointer to the loaded file, or 0 if error
 
-SDL_Surface * LoadColorKeyedImage( char const * filename, SDL_Color key ) 
+SDL_Surface * LoadColorKeyedImage( char const * filename, SDL_Color key, SDL_PixelFormat * format/* = 0*/ ) 
 {
-	SDL_Surface *	image	= LoadImage( filename );
+	SDL_Surface *	image	= LoadImage( filename, format );
 
 	if ( image != 0 )
     {
 		Uint32 colorkey = SDL_MapRGB( image->format, key.r, key.g, key.b );
 		SDL_SetColorKey( image, SDL_RLEACCEL | SDL_SRCCOLORKEY, colorkey );
+		MemoryTracker::Instance().Refresh( image );
     }
 
 	return image;
 }
 
 
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function unregisters an image from the MemoryTracker and frees it.
+//!
+//! @param	image	image to free (may be 0)
+
+void FreeImage( SDL_Surface * image )
+{
+	if ( image != 0 )
+	{
+		MemoryTracker::Instance().Remove( image );
+		SDL_FreeSurface( image );
+	}
+}
+
+
 /********************************************************************************************************************/
 /*																													*/
 /********************************************************************************************************************/
@@ -194,4 +234,60 @@ SDL_Rect MakeRect( int x, int y, int w, int h )
 }
 
 
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function checks a printf-style pattern that is used to generate file names from numbers, so that a
+//! pattern from a data file or a caller cannot cause a crash or an overflow when it is used. The pattern must contain
+//! exactly the specified number of integer conversions (%d or %i) and no other conversions. Flags and a field width
+//! of up to 2 digits are allowed, so each conversion produces at most 99 characters. "%%" is allowed.
+//!
+//! @param	pattern		pattern to check
+//! @param	count		number of integer conversions that the pattern must contain
+//!
+//! @return		true if the pattern is valid
+
+bool IsValidNumberPattern( char const * pattern, int count )
+{
+	int	conversions	= 0;
+
+	for ( char const * p = pattern; *p != 0; ++p )
+	{
+		if ( *p != '%' )
+		{
+			continue;
+		}
+
+		++p;
+		if ( *p == '%' )
+		{
+			continue;
+		}
+
+		while ( *p == '-' || *p == '+' || *p == ' ' || *p == '0' || *p == '#' )
+		{
+			++p;
+		}
+
+		for ( int digits = 0; *p >= '0' && *p <= '9'; ++digits, ++p )
+		{
+			if ( digits >= 2 )
+			{
+				return false;
+			}
+		}
+
+		if ( *p != 'd' && *p != 'i' )
+		{
+			return false;
+		}
+
+		++conversions;
+	}
+
+	return conversions == count;
+}
+
+
 } // namespace Sdlx
@@ -19,10 +19,15 @@
 namespace Sdlx
 {
 	//! Loads an image file.
-	SDL_Surface * LoadImage( char const * filename );
+	//! @note	The image is registered with the MemoryTracker and must be freed with FreeImage(), not SDL_FreeSurface().
+	SDL_Surface * LoadImage( char const * filename, SDL_PixelFormat * format = 0 );
 
 	//! Loads an image file and applies a color key
-	SDL_Surface * LoadColorKeyedImage( char const * filename, SDL_Color key ) ;
+	//! @note	The image is registered with the MemoryTracker and must be freed with FreeImage(), not SDL_FreeSurface().
+	SDL_Surface * LoadColorKeyedImage( char const * filename, SDL_Color key, SDL_PixelFormat * format = 0 ) ;
+
+	//! Frees an image loaded by LoadImage or LoadColorKeyedImage.
+	void FreeImage( SDL_Surface * image );
 
 	//! Idle processing callback.
 	typedef bool (*EventLoopIdleCallback)();
@@ -39,5 +44,8 @@ namespace Sdlx
 	//! Returns a rect with the specified values
 	SDL_Rect MakeRect( int x, int y, int w, int h );
 
+	//! Returns true if a printf-style file name pattern contains exactly @a count bounded integer conversions
+	bool IsValidNumberPattern( char const * pattern, int count );
+
 } // namespace Sdlx
 
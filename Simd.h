@@ -0,0 +1,23 @@
+/** @file *//********************************************************************************************************
+
+                                                        Simd.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/Simd.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+//! @def	SDLX_USE_SSE2
+//! Defined if the compiler targets SSE2, in which case the SSE2 intrinsics are available.
+
+#if defined( __SSE2__ ) || defined( _M_X64 ) || ( defined( _M_IX86_FP ) && _M_IX86_FP >= 2 )
+#define SDLX_USE_SSE2
+#include <emmintrin.h>
+#endif
@@ -15,6 +15,12 @@
 
 #include "Sprite.h"
 
+#include "AnimationClock.h"
+#include "PremultipliedSheet.h"
+#include "TiledSheet.h"
+
+#include <cmath>
+
 namespace Sdlx
 {
 
@@ -24,6 +30,10 @@ namespace Sdlx
 /********************************************************************************************************************/
 
 Sprite::Sprite()
+	:	m_layer( 0 ),
+		m_sheet( 0 ),
+		m_pTiledSheet( 0 ),
+		m_pPremultipliedSheet( 0 )
 {
 }
 
@@ -50,12 +60,77 @@ Sprite::Sprite( SDL_Surface *		sheet,
 				float				x/* = 0*/,
 				float				y/* = 0*/ )
 	:	m_sheet( sheet ),
+		m_pTiledSheet( 0 ),
+		m_pPremultipliedSheet( 0 ),
+		m_rect( rect ),
+		m_offsetX( offsetX ),
+		m_offsetY( offsetY ),
+		m_x( x ),
+		m_y( y ),
+		m_layer( 0 )
+{
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	sheet				TiledSheet containing the sprite's image
+//! @param	rect				The location and size of the sprite's image on the sheet
+//! @param	offsetX,offsetY		Offset to the origin of the sprite
+//! @param	x,y					Initial location of the sprite
+//!
+//! @note	Only the tiles overlapping the sprite's image are loaded when the sprite is drawn.
+
+Sprite::Sprite( TiledSheet *		sheet,
+				SDL_Rect const &	rect,
+				int					offsetX/* = 0*/,
+				int					offsetY/* = 0*/,
+				float				x/* = 0*/,
+				float				y/* = 0*/ )
+	:	m_sheet( 0 ),
+		m_pTiledSheet( sheet ),
+		m_pPremultipliedSheet( 0 ),
+		m_rect( rect ),
+		m_offsetX( offsetX ),
+		m_offsetY( offsetY ),
+		m_x( x ),
+		m_y( y ),
+		m_layer( 0 )
+{
+	assert( sheet != 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	sheet				PremultipliedSheet containing the sprite's image
+//! @param	rect				The location and size of the sprite's image on the sheet
+//! @param	offsetX,offsetY		Offset to the origin of the sprite
+//! @param	x,y					Initial location of the sprite
+//!
+//! @note	The sprite must be drawn to a 32-bit surface with the same color masks as the sheet.
+
+Sprite::Sprite( PremultipliedSheet const *	sheet,
+				SDL_Rect const &			rect/* = MakeRect( 0, 0, 0, 0 )*/,
+				int							offsetX/* = 0*/,
+				int							offsetY/* = 0*/,
+				float						x/* = 0*/,
+				float						y/* = 0*/ )
+	:	m_sheet( 0 ),
+		m_pTiledSheet( 0 ),
+		m_pPremultipliedSheet( sheet ),
 		m_rect( rect ),
 		m_offsetX( offsetX ),
 		m_offsetY( offsetY ),
 		m_x( x ),
-		m_y( y )
+		m_y( y ),
+		m_layer( 0 )
 {
+	assert( sheet != 0 );
 }
 
 
@@ -82,11 +157,53 @@ void Sprite::Draw( SDL_Surface * dst ) const
 	SDL_Rect			position	= { int( m_x - m_offsetX + 0.5f ), int( m_y - m_offsetY + 0.5f ), 0, 0 };
 	SDL_Rect const *	pRect		= ( m_rect.w > 0 && m_rect.h > 0 ) ? &m_rect : NULL;
 
+	if ( m_pTiledSheet != 0 )
+	{
+		if ( pRect != NULL )
+		{
+			m_pTiledSheet->Blit( pRect->x, pRect->y, pRect->w, pRect->h, dst, position.x, position.y );
+		}
+		else
+		{
+			m_pTiledSheet->Blit( 0, 0, m_pTiledSheet->GetWidth(), m_pTiledSheet->GetHeight(), dst, position.x, position.y );
+		}
+		return;
+	}
+
+	if ( m_pPremultipliedSheet != 0 )
+	{
+		m_pPremultipliedSheet->Blit( pRect, dst, position.x, position.y );
+		return;
+	}
+
 	rv = SDL_BlitSurface( m_sheet, const_cast< SDL_Rect * >( pRect ), dst, &position );
 	assert( rv == 0 );
 }
 
 
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! Sprites are drawn in increasing order of their keys. The key orders sprites first by layer and then by the y
+//! coordinate of their origins, so that within a layer, sprites lower on the display are drawn over sprites higher
+//! on the display.
+//!
+//! @note	The y coordinate is rounded the same way as in Draw() and clamped to the range -8388608 - 8388607. The
+//!			layer is clamped to the range -128 - 127.
+
+Uint32 Sprite::GetSortKey() const
+{
+	assert( m_layer >= -128 && m_layer <= 127 );
+
+	int		row		= int( std::min( std::max( m_y + 0.5f, -8388608.0f ), 8388607.0f ) );
+	Uint32	layer	= Uint32( std::min( std::max( m_layer, -0x80 ), 0x7f ) + 0x80 );
+	Uint32	y		= Uint32( row + 0x800000 );
+
+	return ( layer << 24 ) | y;
+}
+
+
 /********************************************************************************************************************/
 /*																													*/
 /********************************************************************************************************************/
@@ -97,7 +214,12 @@ AnimatedSprite::AnimatedSprite()
 		m_currentFrame( 0 ),
 		m_time( 0.0f ),
 		m_frameTime( 0.0f ),
-		m_direction( DIR_FORWARD )
+		m_direction( DIR_FORWARD ),
+		m_startDirection( DIR_FORWARD ),
+		m_pClock( 0 ),
+		m_startClockTime( 0.0 ),
+		m_clockTime( 0.0 ),
+		m_updateInterval( 0.0f )
 {
 }
 
@@ -125,7 +247,45 @@ AnimatedSprite::AnimatedSprite( SDL_Surface *			sheet,
 		m_currentFrame( 0 ),
 		m_time( 0.0f ),
 		m_frameTime( 0.0f ),
-		m_direction( DIR_FORWARD )
+		m_direction( DIR_FORWARD ),
+		m_startDirection( DIR_FORWARD ),
+		m_pClock( 0 ),
+		m_startClockTime( 0.0 ),
+		m_clockTime( 0.0 ),
+		m_updateInterval( 0.0f )
+{
+	assert( animations != 0 );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//!
+//! @param	sheet			PremultipliedSheet containing the sprite's animation frames
+//! @param	animations		Description of the sprite's animations
+//! @param	x,y				Initial location of the sprite
+//!
+//! @note	The sprite does not assume ownership of the sheet or the animation group.
+//! @note	The sprite must be drawn to a 32-bit surface with the same color masks as the sheet.
+
+AnimatedSprite::AnimatedSprite( PremultipliedSheet const *	sheet,
+								AnimationGroup const *		animations,
+								float 						x/* = 0*/,
+								float 						y/* = 0*/ )
+	:	Sprite( sheet, MakeRect( 0, 0, 0, 0 ), 0, 0, x, y ),
+		m_pAnimations( animations ),
+		m_currentAnimation( 0 ),
+		m_currentFrame( 0 ),
+		m_time( 0.0f ),
+		m_frameTime( 0.0f ),
+		m_direction( DIR_FORWARD ),
+		m_startDirection( DIR_FORWARD ),
+		m_pClock( 0 ),
+		m_startClockTime( 0.0 ),
+		m_clockTime( 0.0 ),
+		m_updateInterval( 0.0f )
 {
 	assert( animations != 0 );
 }
@@ -158,19 +318,20 @@ void AnimatedSprite::PlayAnimation( int index, Direction direction/* = DIR_FORWA
 
 	m_currentAnimation	= index;
 	m_direction			= direction;
+	m_startDirection	= direction;
 	m_currentFrame		= ( direction == DIR_FORWARD ) ? 0 : int( frames.size() ) - 1;
 	m_time				= 0.0f;
 	m_frameTime			= 0.0f;
 
-	// Set the image location and size according to the current frame
+	if ( m_pClock != 0 )
+	{
+		m_clockTime			= m_pClock->GetTime();
+		m_startClockTime	= m_clockTime;
+	}
 
-	Frame const &						frame	= frames[ m_currentFrame ];	// Convenience
-	AnimationGroup::ImageList const &	images	= m_pAnimations->images;	// Convenience
-	AnimationGroup::Image const &		image	= images[ frame.index ];	// Convenience
+	// Set the image location and size according to the current frame
 
-	m_rect		= image.rect;
-	m_offsetX	= image.offsetX;
-	m_offsetY	= image.offsetY;
+	UpdateImage();
 }
 
 
@@ -221,6 +382,8 @@ void AnimatedSprite::AdvanceTime( float elapsed )
 
 	float e	= elapsed + m_frameTime;
 
+	m_frameTime = 0.0f;		// In case the time ends exactly at the end of a frame
+
 	// Set the initial parameters based on the current direction
 
 	int step;
@@ -277,17 +440,19 @@ void AnimatedSprite::AdvanceTime( float elapsed )
 
 	// Set the image location and size according to the current frame
 
-	Frame const &						frame	= frames[ m_currentFrame ];		// Convenience
-	AnimationGroup::ImageList const &	images	= m_pAnimations->images;		// Convenience
-	AnimationGroup::Image const &		image	= images[ frame.index ];		// Convenience
-
-	m_rect		= image.rect;
-	m_offsetX	= image.offsetX;
-	m_offsetY	= image.offsetY;
+	UpdateImage();
 
 	// Save the time
 
 	m_time += elapsed;
+
+	// If driven by a clock, the animation is now further along than the clock indicates, so it effectively started
+	// earlier
+
+	if ( m_pClock != 0 )
+	{
+		m_startClockTime -= elapsed;
+	}
 }
 
 
@@ -333,18 +498,19 @@ void AnimatedSprite::SetFrame( int index )
 		break;
 	}
 
-	m_currentFrame	= index;
-	m_frameTime		= 0.0f;
+	m_currentFrame		= index;
+	m_frameTime			= 0.0f;
+	m_startDirection	= m_direction;
 
-	// Set the image location and size according to the current frame
+	if ( m_pClock != 0 )
+	{
+		m_clockTime			= m_pClock->GetTime();
+		m_startClockTime	= m_clockTime - m_time;
+	}
 
-	Frame const &						frame	= frames[ m_currentFrame ];		// Convenience
-	AnimationGroup::ImageList const &	images	= m_pAnimations->images;		// Convenience
-	AnimationGroup::Image const &		image	= images[ frame.index ];		// Convenience
+	// Set the image location and size according to the current frame
 
-	m_rect		= image.rect;
-	m_offsetX	= image.offsetX;
-	m_offsetY	= image.offsetY;
+	UpdateImage();
 }
 
 
@@ -355,12 +521,217 @@ void AnimatedSprite::SetFrame( int index )
 //! This function will update the animation based on the amount of time that has elapsed since it was last called.
 //!
 //! @param	elapsedTime		Time elapsed since this function was last called (must be >= 0)
+//!
+//! @note	If the animation is driven by a clock, the elapsed time is ignored and the animation is updated according
+//!			to the clock. Calling this function is not necessary in that case.
 
 void AnimatedSprite::Service( float elapsedTime )
 {
 	assert( elapsedTime >= 0.0f );
 
-	AdvanceTime( elapsedTime );
+	if ( m_pClock != 0 )
+	{
+		Evaluate();
+	}
+	else
+	{
+		AdvanceTime( elapsedTime );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! When a sprite is driven by a clock, it does not need to be serviced. Its current frame is computed from the
+//! clock's time when it is drawn or when its time or frame is queried. The current state of the animation is
+//! preserved, and the animation continues from that point as the clock advances.
+//!
+//! @param	pClock		The clock (usually AnimationClock::Global()), or 0 to drive the animation with Service()
+//!
+//! @note	The sprite does not assume ownership of the clock, so it can be shared by many sprites.
+
+void AnimatedSprite::SetClock( AnimationClock const * pClock )
+{
+	Evaluate();
+
+	// Preserve the time since the animation started in double precision if it is known
+
+	double	time	= ( m_pClock != 0 ) ? m_clockTime - m_startClockTime : double( m_time );
+
+	m_pClock = pClock;
+
+	if ( m_pClock != 0 )
+	{
+		m_clockTime			= m_pClock->GetTime();
+		m_startClockTime	= m_clockTime - time;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! If the sprite is driven by a clock, its animation is brought up to date before it is drawn.
+//!
+//! @param	dst		destination surface
+
+void AnimatedSprite::Draw( SDL_Surface * dst ) const
+{
+	Evaluate();
+	Sprite::Draw( dst );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Brings the animation up to date with the clock (if any). If an update interval is set, the clock's time is
+// rounded down to a multiple of the interval, so the animation is only updated once per interval. The state of the
+// animation is a cache of the clock's time, so it is updated even though this function is const.
+//
+// The state is computed from the time since the animation started rather than by accumulating the time since the
+// last update, so it depends only on the clock and not on how often the sprite is evaluated. If the clock is moved
+// backwards, the start time is kept, so the animation shows the state it had at that time (or its first frame if
+// the clock is moved to before the animation started).
+
+void AnimatedSprite::Evaluate() const
+{
+	if ( m_pClock == 0 )
+	{
+		return;
+	}
+
+	double	now	= m_pClock->GetTime();
+
+	if ( m_updateInterval > 0.0f )
+	{
+		now = floor( now / m_updateInterval ) * m_updateInterval;
+	}
+
+	if ( now == m_clockTime )
+	{
+		return;
+	}
+
+	EvaluateAt( std::max( now - m_startClockTime, 0.0 ) );
+	m_clockTime = now;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Sets the state of the animation to the specified time since it started. Unlike AdvanceTime(), the cost does not
+// depend on the amount of time that has passed. The position within the cycle is computed in double precision, so
+// it remains accurate when the time is large.
+
+void AnimatedSprite::EvaluateAt( double time ) const
+{
+	Animation const &				animation	= m_pAnimations->animations[ m_currentAnimation ];	// Convenience
+	Animation::FrameList const &	frames		= animation.frames;									// Convenience
+
+	float	duration	= 0.0f;
+
+	for ( Animation::FrameList::const_iterator i = frames.begin(); i != frames.end(); ++i )
+	{
+		duration += i->time;
+	}
+
+	if ( duration <= 0.0f )
+	{
+		return;
+	}
+
+	Direction	reverse	= ( m_startDirection == DIR_FORWARD ) ? DIR_BACKWARD : DIR_FORWARD;
+
+	switch ( animation.mode )
+	{
+	case Animation::MODE_ONCE:
+		m_direction = m_startDirection;
+		WalkFrames( float( std::min( time, double( duration ) ) ), m_direction );
+		break;
+
+	case Animation::MODE_LOOP:
+		m_direction = m_startDirection;
+		WalkFrames( float( fmod( time, double( duration ) ) ), m_direction );
+		break;
+
+	case Animation::MODE_PINGPONG:
+	{
+		// One cycle is a pass in the starting direction followed by a pass in the reverse direction
+
+		double	t	= fmod( time, 2.0 * duration );
+
+		if ( t < duration )
+		{
+			m_direction = m_startDirection;
+			WalkFrames( float( t ), m_direction );
+		}
+		else
+		{
+			m_direction = reverse;
+			WalkFrames( float( t - duration ), m_direction );
+		}
+		break;
+	}
+	}
+
+	m_time = float( time );
+
+	// Set the image location and size according to the current frame
+
+	UpdateImage();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Sets the current frame to the frame at the specified time from the start of a single pass through the frames in
+// the specified direction. If the time is past the end, the last frame is used.
+
+void AnimatedSprite::WalkFrames( float time, Direction direction ) const
+{
+	Animation::FrameList const &	frames	= m_pAnimations->animations[ m_currentAnimation ].frames;	// Convenience
+	int								n		= int( frames.size() );
+
+	for ( int k = 0; k < n; ++k )
+	{
+		int	i	= ( direction == DIR_FORWARD ) ? k : n - 1 - k;
+
+		if ( time < frames[i].time || k == n - 1 )
+		{
+			m_currentFrame	= i;
+			m_frameTime		= time;
+			return;
+		}
+
+		time -= frames[i].time;
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+// Sets the image location and size according to the current frame
+
+void AnimatedSprite::UpdateImage() const
+{
+	Animation const &					animation	= m_pAnimations->animations[ m_currentAnimation ];	// Convenience
+	Frame const &						frame		= animation.frames[ m_currentFrame ];				// Convenience
+	AnimationGroup::Image const &		image		= m_pAnimations->images[ frame.index ];				// Convenience
+
+	m_rect		= image.rect;
+	m_offsetX	= image.offsetX;
+	m_offsetY	= image.offsetY;
 }
 
 
@@ -23,7 +23,10 @@
 namespace Sdlx
 {
 
+class AnimationClock;
+class PremultipliedSheet;
 class SpriteAnimationGroup;
+class TiledSheet;
 
 /********************************************************************************************************************/
 /*																													*/
@@ -32,7 +35,8 @@ class SpriteAnimationGroup;
 //! A sprite
 //
 //! A sprite is a 2D rectangular image that has a location on the display. The image is generally implemented as a
-//! sub-region of a "sheet". The sprite also has an origin specified as an offset from the UL corner.
+//! sub-region of a "sheet". The sprite also has an origin specified as an offset from the UL corner. The sheet can
+//! be a surface, a TiledSheet, or a PremultipliedSheet.
 
 class Sprite
 {
@@ -48,21 +52,45 @@ public:
 			float				x = 0,
 			float				y = 0 );
 
+	//! Constructor
+	Sprite( TiledSheet *		sheet,
+			SDL_Rect const &	rect,
+			int					offsetX = 0,
+			int					offsetY = 0,
+			float				x = 0,
+			float				y = 0 );
+
+	//! Constructor
+	Sprite( PremultipliedSheet const *	sheet,
+			SDL_Rect const &			rect = MakeRect( 0, 0, 0, 0 ),
+			int							offsetX = 0,
+			int							offsetY = 0,
+			float						x = 0,
+			float						y = 0 );
+
 	// Destructor
 	virtual ~Sprite();
 
 	//! Draws the sprite
-	void Draw( SDL_Surface * dst ) const;
+	virtual void Draw( SDL_Surface * dst ) const;
+
+	//! Returns the key used to determine the drawing order
+	Uint32 GetSortKey() const;
 
-	float		m_x;		//!< Location of the sprite's origin on the display
-	float		m_y;		//!< Location of the sprite's origin on the display
-	SDL_Rect	m_rect;		//!< Location and size of the sprite in the image
-	int			m_offsetX;	//!< Offset from the the UL corner to the sprite's origin
-	int			m_offsetY;	//!< Offset from the the UL corner to the sprite's origin
+	// The image is mutable because AnimatedSprite updates it lazily when it is drawn
+
+	float				m_x;		//!< Location of the sprite's origin on the display
+	float				m_y;		//!< Location of the sprite's origin on the display
+	mutable SDL_Rect	m_rect;		//!< Location and size of the sprite in the image
+	mutable int			m_offsetX;	//!< Offset from the the UL corner to the sprite's origin
+	mutable int			m_offsetY;	//!< Offset from the the UL corner to the sprite's origin
+	int					m_layer;	//!< Drawing layer (-128 - 127). Higher layers are drawn over lower layers.
 
 private:
 
-	SDL_Surface	*	m_sheet;	// The sheet containing the sprite's image
+	SDL_Surface	*				m_sheet;				// The sheet containing the sprite's image
+	TiledSheet *				m_pTiledSheet;			// The tiled sheet containing the sprite's image (if any)
+	PremultipliedSheet const *	m_pPremultipliedSheet;	// The premultiplied sheet containing the sprite's image (if any)
 };
 
 
@@ -88,6 +116,13 @@ private:
 //! An animation is simply a list of frames and a mode that determines what to do when the end of the list of
 //! frames is reached. Each frame contains the index of its image (in the image list) and its
 //! duration.
+//!
+//! Clock-driven animation
+//!
+//! Normally, the animation is advanced by calling Service() every frame. Alternatively, the sprite can be driven by
+//! an AnimationClock. In that case, the sprite only records when its animation started, and its current frame is
+//! computed from the clock when it is drawn or queried, so a sprite that is not drawn costs nothing. The update
+//! interval can be increased for sprites that are distant or off-screen so that they are updated less often.
 
 class AnimatedSprite : public Sprite
 {
@@ -156,6 +191,9 @@ public:
 	//! Constructor
 	AnimatedSprite( SDL_Surface * sheet, AnimationGroup const * animations, float x = 0, float y = 0 );
 
+	//! Constructor
+	AnimatedSprite( PremultipliedSheet const * sheet, AnimationGroup const * animations, float x = 0, float y = 0 );
+
 	// Destructor
 	virtual ~AnimatedSprite();
 
@@ -175,22 +213,50 @@ public:
 	int GetAnimation() const					{ return m_currentAnimation; }
 
 	//! Returns the current time (in seconds)
-	float GetTime() const						{ return m_time; }
+	float GetTime() const						{ Evaluate(); return m_time; }
 
 	//! Returns the current animation frame
-	int GetFrame() const						{ return m_currentFrame; }
+	int GetFrame() const						{ Evaluate(); return m_currentFrame; }
 
 	//! Updates the state of the sprite animation
 	void Service( float elapsedTime );
 
+	//! Drives the animation with a clock (or 0 to drive it with Service)
+	void SetClock( AnimationClock const * pClock );
+
+	//! Returns the clock driving the animation (or 0 if none)
+	AnimationClock const * GetClock() const		{ return m_pClock; }
+
+	//! Sets the minimum time between updates when driven by a clock (0 means always update)
+	void SetUpdateInterval( float interval )	{ m_updateInterval = interval; }
+
+	//! Returns the minimum time between updates when driven by a clock
+	float GetUpdateInterval() const				{ return m_updateInterval; }
+
+	//! Draws the sprite
+	virtual void Draw( SDL_Surface * dst ) const;
+
 private:
 
+	void Evaluate() const;
+	void EvaluateAt( double time ) const;
+	void WalkFrames( float time, Direction direction ) const;
+	void UpdateImage() const;
+
+	// The state of the current animation is mutable because a sprite driven by a clock updates it lazily when it
+	// is queried or drawn.
+
 	AnimationGroup const *	m_pAnimations;			// The animation group
 	int						m_currentAnimation;		// The index of the current animation
-	int						m_currentFrame;			// The index of the current frame
-	float					m_time;					// The current position of the animation
-	float					m_frameTime;			// The time from the start of the current frame
-	Direction				m_direction;			// The direction that the animation is playing
+	mutable int				m_currentFrame;			// The index of the current frame
+	mutable float			m_time;					// The current position of the animation
+	mutable float			m_frameTime;			// The time from the start of the current frame
+	mutable Direction		m_direction;			// The direction that the animation is playing
+	Direction				m_startDirection;		// The direction that the animation started playing
+	AnimationClock const *	m_pClock;				// The clock driving the animation (or 0 if none)
+	double					m_startClockTime;		// The clock's time when the animation was at time 0
+	mutable double			m_clockTime;			// The clock's time corresponding to the current state
+	float					m_updateInterval;		// Minimum time between updates when driven by a clock
 };
 
 
@@ -0,0 +1,448 @@
+/** @file *//********************************************************************************************************
+
+                                                    TiledSheet.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/TiledSheet.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#include "PrecompiledHeaders.h"
+
+#include "TiledSheet.h"
+
+#include "MemoryTracker.h"
+#include "Sdlx.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+
+	// Returns the directory part of a path, including the trailing separator (or an empty string if none)
+
+	std::string DirectoryOf( char const * path )
+	{
+		char const *	slash		= strrchr( path, '/' );
+		char const *	backslash	= strrchr( path, '\\' );
+
+		if ( backslash > slash )
+		{
+			slash = backslash;
+		}
+
+		return ( slash != 0 ) ? std::string( path, slash + 1 ) : std::string();
+	}
+
+
+	// Returns the string with each '%' doubled so that it can be used in a printf-style pattern
+
+	std::string EscapePercents( std::string const & s )
+	{
+		std::string	escaped;
+
+		for ( std::string::const_iterator i = s.begin(); i != s.end(); ++i )
+		{
+			if ( *i == '%' )
+			{
+				escaped += '%';
+			}
+			escaped += *i;
+		}
+
+		return escaped;
+	}
+
+
+	// Returns true if the path is absolute
+
+	bool IsAbsolute( char const * path )
+	{
+		return path[0] == '/' || path[0] == '\\' || ( path[0] != 0 && path[1] == ':' );
+	}
+
+
+} // anonymous namespace
+
+
+namespace Sdlx
+{
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! @param	width,height			Size of the sheet
+//! @param	tileWidth,tileHeight	Size of a tile
+//! @param	pattern					printf-style pattern used to generate a tile's file name from its column and row
+//! @param	maxTiles				Maximum number of tiles loaded at once
+
+TiledSheet::TiledSheet( int				width,
+						int				height,
+						int				tileWidth,
+						int				tileHeight,
+						char const *	pattern,
+						int				maxTiles/* = 64*/ )
+	:	m_width( width ),
+		m_height( height ),
+		m_tileWidth( tileWidth ),
+		m_tileHeight( tileHeight ),
+		m_columns( ( width + tileWidth - 1 ) / tileWidth ),
+		m_rows( ( height + tileHeight - 1 ) / tileHeight ),
+		m_pattern( pattern ),
+		m_maxTiles( maxTiles ),
+		m_colorKeyed( false ),
+		m_lastViewX( 0 ),
+		m_lastViewY( 0 ),
+		m_hasLastView( false )
+{
+	assert( width > 0 && height > 0 );
+	assert( tileWidth > 0 && tileHeight > 0 );
+	assert( maxTiles > 0 );
+	assert( IsValidNumberPattern( pattern, 2 ) );
+
+	Tile	empty	= { 0, m_lru.end(), false };
+
+	m_tiles.resize( m_columns * m_rows, empty );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+TiledSheet::~TiledSheet()
+{
+	Flush();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function loads a tiled sheet description. No tiles are loaded. Ownership of the sheet is passed to the
+//! caller. The sheet must be deallocated using delete.
+//!
+//! @param	filename	name of the file containing the description
+//! @param	maxTiles	maximum number of tiles loaded at once
+//!
+//! @return		The new sheet, or 0 if error
+
+TiledSheet * TiledSheet::Load( char const * filename, int maxTiles/* = 64*/ )
+{
+	FILE *	fp	= fopen( filename, "r" );
+
+	if ( fp == 0 )
+	{
+		return 0;
+	}
+
+	int		width;
+	int		height;
+	int		tileWidth;
+	int		tileHeight;
+	char	pattern[ 1024 ];
+	int		nFields	= fscanf( fp, "%d %d %d %d %1023s", &width, &height, &tileWidth, &tileHeight, pattern );
+
+	fclose( fp );
+
+	if ( nFields != 5 || width <= 0 || height <= 0 || tileWidth <= 0 || tileHeight <= 0 )
+	{
+		return 0;
+	}
+
+	// The pattern comes from a data file and is used as a printf format, so it must be validated
+
+	if ( !IsValidNumberPattern( pattern, 2 ) )
+	{
+		return 0;
+	}
+
+	std::string	path	= IsAbsolute( pattern ) ? std::string( pattern ) : EscapePercents( DirectoryOf( filename ) ) + pattern;
+
+	return new TiledSheet( width, height, tileWidth, tileHeight, path.c_str(), maxTiles );
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! The color key is applied to tiles that are already loaded and to tiles loaded later.
+//!
+//! @param	key		color key
+
+void TiledSheet::SetColorKey( SDL_Color key )
+{
+	m_colorKeyed	= true;
+	m_key			= key;
+
+	for ( LruList::iterator i = m_lru.begin(); i != m_lru.end(); ++i )
+	{
+		SDL_Surface *	surface		= m_tiles[ *i ].surface;
+		Uint32			colorkey	= SDL_MapRGB( surface->format, key.r, key.g, key.b );
+
+		SDL_SetColorKey( surface, SDL_RLEACCEL | SDL_SRCCOLORKEY, colorkey );
+		MemoryTracker::Instance().Refresh( surface );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function draws a region of the sheet, loading any tiles that are not already loaded. The region is clipped
+//! to the sheet.
+//!
+//! @param	srcX,srcY	Location of the region on the sheet
+//! @param	w,h			Size of the region
+//! @param	dst			Destination surface
+//! @param	x,y			Location of the region on the destination surface
+
+void TiledSheet::Blit( int srcX, int srcY, int w, int h, SDL_Surface * dst, int x, int y )
+{
+	// Clip the region to the sheet
+
+	int	left	= std::max( srcX, 0 );
+	int	top		= std::max( srcY, 0 );
+	int	right	= std::min( srcX + w, m_width );
+	int	bottom	= std::min( srcY + h, m_height );
+
+	if ( left >= right || top >= bottom )
+	{
+		return;
+	}
+
+	// Draw the part of each tile that overlaps the region
+
+	for ( int row = top / m_tileHeight; row <= ( bottom - 1 ) / m_tileHeight; ++row )
+	{
+		for ( int column = left / m_tileWidth; column <= ( right - 1 ) / m_tileWidth; ++column )
+		{
+			SDL_Surface *	tile	= GetTile( column, row );
+
+			if ( tile == 0 )
+			{
+				continue;
+			}
+
+			int	tileX	= column * m_tileWidth;
+			int	tileY	= row * m_tileHeight;
+			int	x0		= std::max( left, tileX );
+			int	y0		= std::max( top, tileY );
+			int	x1		= std::min( right, tileX + m_tileWidth );
+			int	y1		= std::min( bottom, tileY + m_tileHeight );
+
+			SDL_Rect	source		= MakeRect( x0 - tileX, y0 - tileY, x1 - x0, y1 - y0 );
+			SDL_Rect	position	= MakeRect( x + x0 - srcX, y + y0 - srcY, 0, 0 );
+			int			rv;
+
+			rv = SDL_BlitSurface( tile, &source, dst, &position );
+			assert( rv == 0 );
+		}
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! This function loads tiles that are likely to be drawn soon so that they do not have to be loaded when they are
+//! drawn. The tiles in the view are loaded first, then the tiles just outside the view in the direction that the
+//! view is moving, then the tiles bordering the view. In order to limit the time spent in a single frame, only a
+//! limited number of tiles are loaded per call. Loaded tiles in the view are marked as recently used.
+//!
+//! This function is meant to be called once per frame with the current view.
+//!
+//! @param	viewX,viewY		Location of the view on the sheet
+//! @param	viewW,viewH		Size of the view
+//! @param	maxLoads		Maximum number of tiles to load
+
+void TiledSheet::Prefetch( int viewX, int viewY, int viewW, int viewH, int maxLoads/* = 1*/ )
+{
+	int	dx	= m_hasLastView ? viewX - m_lastViewX : 0;
+	int	dy	= m_hasLastView ? viewY - m_lastViewY : 0;
+
+	m_lastViewX		= viewX;
+	m_lastViewY		= viewY;
+	m_hasLastView	= true;
+
+	int	loads	= maxLoads;
+
+	// Visible tiles first
+
+	LoadTilesInRegion( viewX, viewY, viewW, viewH, &loads );
+
+	// Then the tiles that the view is moving towards, but only if there is room for them without evicting visible
+	// tiles
+
+	int	ahead	= ( ( viewW + m_tileWidth - 1 ) / m_tileWidth + 2 ) * ( ( viewH + m_tileHeight - 1 ) / m_tileHeight + 2 );
+
+	if ( ( dx != 0 || dy != 0 ) && ahead <= m_maxTiles )
+	{
+		int	aheadX	= viewX + ( dx > 0 ? m_tileWidth : ( dx < 0 ? -m_tileWidth : 0 ) );
+		int	aheadY	= viewY + ( dy > 0 ? m_tileHeight : ( dy < 0 ? -m_tileHeight : 0 ) );
+
+		LoadTilesInRegion( aheadX, aheadY, viewW, viewH, &loads );
+	}
+
+	// Then all tiles bordering the view, but only if there is room for them without evicting visible tiles
+
+	int	border	= ( ( viewW + m_tileWidth - 1 ) / m_tileWidth + 3 ) * ( ( viewH + m_tileHeight - 1 ) / m_tileHeight + 3 );
+
+	if ( border <= m_maxTiles )
+	{
+		LoadTilesInRegion( viewX - m_tileWidth, viewY - m_tileHeight, viewW + 2 * m_tileWidth, viewH + 2 * m_tileHeight, &loads );
+	}
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void TiledSheet::Flush()
+{
+	for ( LruList::iterator i = m_lru.begin(); i != m_lru.end(); ++i )
+	{
+		Tile &	tile	= m_tiles[ *i ];
+
+		FreeImage( tile.surface );
+		tile.surface	= 0;
+		tile.lruPos		= m_lru.end();
+	}
+
+	m_lru.clear();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+SDL_Surface * TiledSheet::GetTile( int column, int row )
+{
+	assert( column >= 0 && column < m_columns );
+	assert( row >= 0 && row < m_rows );
+
+	int		index	= row * m_columns + column;
+	Tile &	tile	= m_tiles[ index ];
+
+	if ( tile.surface != 0 )
+	{
+		Touch( index );
+		return tile.surface;
+	}
+
+	if ( tile.missing )
+	{
+		return 0;
+	}
+
+	// Load the tile, making room for it first
+
+	if ( int( m_lru.size() ) >= m_maxTiles )
+	{
+		Evict();
+	}
+
+	// The pattern has been validated by Load(), so the name fits: each of the two conversions produces at most 99
+	// characters.
+
+	std::vector< char >	name( m_pattern.size() + 256 );
+
+	snprintf( &name[0], name.size(), m_pattern.c_str(), column, row );
+	name.back() = 0;
+
+	tile.surface = m_colorKeyed ? LoadColorKeyedImage( &name[0], m_key ) : LoadImage( &name[0] );
+
+	if ( tile.surface == 0 )
+	{
+		tile.missing = true;
+		return 0;
+	}
+
+	m_lru.push_front( index );
+	tile.lruPos = m_lru.begin();
+
+	return tile.surface;
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void TiledSheet::Touch( int index )
+{
+	Tile &	tile	= m_tiles[ index ];
+
+	m_lru.splice( m_lru.begin(), m_lru, tile.lruPos );
+	tile.lruPos = m_lru.begin();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void TiledSheet::Evict()
+{
+	assert( !m_lru.empty() );
+
+	Tile &	tile	= m_tiles[ m_lru.back() ];
+
+	FreeImage( tile.surface );
+	tile.surface	= 0;
+	tile.lruPos		= m_lru.end();
+
+	m_lru.pop_back();
+}
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+void TiledSheet::LoadTilesInRegion( int x, int y, int w, int h, int * pLoads )
+{
+	int	left	= std::max( x, 0 );
+	int	top		= std::max( y, 0 );
+	int	right	= std::min( x + w, m_width );
+	int	bottom	= std::min( y + h, m_height );
+
+	if ( left >= right || top >= bottom )
+	{
+		return;
+	}
+
+	for ( int row = top / m_tileHeight; row <= ( bottom - 1 ) / m_tileHeight; ++row )
+	{
+		for ( int column = left / m_tileWidth; column <= ( right - 1 ) / m_tileWidth; ++column )
+		{
+			Tile const &	tile	= m_tiles[ row * m_columns + column ];
+
+			if ( tile.surface != 0 )
+			{
+				Touch( row * m_columns + column );
+			}
+			else if ( !tile.missing && *pLoads > 0 )
+			{
+				GetTile( column, row );
+				--*pLoads;
+			}
+		}
+	}
+}
+
+
+} // namespace Sdlx
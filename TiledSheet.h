@@ -0,0 +1,130 @@
+/** @file *//********************************************************************************************************
+
+                                                     TiledSheet.h
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/TiledSheet.h#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+#pragma once
+
+
+#include <SDL.h>
+
+#include <list>
+#include <string>
+#include <vector>
+
+namespace Sdlx
+{
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+//! A very large sheet that is loaded in tiles as needed
+//
+//! A tiled sheet is a virtual sheet that is stored on disk as a grid of fixed-size tiles, each in its own image
+//! file. Tiles are loaded and converted to the display format only when they are drawn or prefetched, and only a
+//! limited number of tiles are kept in memory. When the limit is reached, the least recently used tile is freed.
+//!
+//! Tiled sheet file format
+//!
+//! A tiled sheet is described by a text file containing the size of the sheet, the size of the tiles, and a
+//! printf-style pattern used to generate the name of each tile's file from its column and row. The pattern must
+//! contain exactly two integer conversions (%d or %i, with an optional field width of up to 2 digits) and no other
+//! conversions. Relative tile names are relative to the directory containing the description. For example:
+//!
+//! @code
+//!		20000 12000 512 512
+//!		backdrop_%03d_%03d.png
+//! @endcode
+//!
+//! The tiles in the last column and row may be smaller than the tile size.
+
+class TiledSheet
+{
+public:
+
+	//! Constructor
+	TiledSheet( int					width,
+				int					height,
+				int					tileWidth,
+				int					tileHeight,
+				char const *		pattern,
+				int					maxTiles = 64 );
+
+	// Destructor
+	virtual ~TiledSheet();
+
+	//! Loads a tiled sheet description
+	static TiledSheet * Load( char const * filename, int maxTiles = 64 );
+
+	//! Sets the color key applied to all tiles
+	void SetColorKey( SDL_Color key );
+
+	//! Draws a region of the sheet
+	void Blit( int srcX, int srcY, int w, int h, SDL_Surface * dst, int x, int y );
+
+	//! Loads the tiles in and around the view in advance
+	void Prefetch( int viewX, int viewY, int viewW, int viewH, int maxLoads = 1 );
+
+	//! Frees all loaded tiles
+	void Flush();
+
+	//! Returns the width of the sheet
+	int GetWidth() const						{ return m_width; }
+
+	//! Returns the height of the sheet
+	int GetHeight() const						{ return m_height; }
+
+	//! Returns the number of tiles currently loaded
+	int GetLoadedTileCount() const				{ return int( m_lru.size() ); }
+
+private:
+
+	typedef std::list< int >	LruList;
+
+	// A tile
+	struct Tile
+	{
+		SDL_Surface *		surface;	// The tile's image (or 0 if not loaded)
+		LruList::iterator	lruPos;		// The tile's position in the LRU list (only valid if loaded)
+		bool				missing;	// True if the tile failed to load
+	};
+
+	typedef std::vector< Tile >	TileList;
+
+	// Prevent copying
+	TiledSheet( TiledSheet const & );
+	TiledSheet & operator =( TiledSheet const & );
+
+	SDL_Surface * GetTile( int column, int row );
+	void Touch( int index );
+	void Evict();
+	void LoadTilesInRegion( int x, int y, int w, int h, int * pLoads );
+
+	int				m_width;			// Width of the sheet
+	int				m_height;			// Height of the sheet
+	int				m_tileWidth;		// Width of a tile
+	int				m_tileHeight;		// Height of a tile
+	int				m_columns;			// Number of columns of tiles
+	int				m_rows;				// Number of rows of tiles
+	std::string		m_pattern;			// Pattern used to generate the tile file names
+	int				m_maxTiles;			// Maximum number of tiles loaded at once
+	bool			m_colorKeyed;		// True if a color key is applied to the tiles
+	SDL_Color		m_key;				// Color key applied to the tiles
+	TileList		m_tiles;			// All the tiles
+	LruList			m_lru;				// Indexes of loaded tiles, most recently used first
+	int				m_lastViewX;		// Location of the view in the previous call to Prefetch
+	int				m_lastViewY;		// Location of the view in the previous call to Prefetch
+	bool			m_hasLastView;		// True if Prefetch has been called
+};
+
+
+} // namespace Sdlx
@@ -0,0 +1,498 @@
+/** @file *//********************************************************************************************************
+
+                                                 SpriteThumbnails.cpp
+
+						                    Copyright 2006, John J. Bolton
+	--------------------------------------------------------------------------------------------------------------
+
+	$Header: //depot/Libraries/Sdlx/Tools/SpriteThumbnails.cpp#1 $
+
+	$NoKeywords: $
+
+ ********************************************************************************************************************/
+
+//! Renders contact sheets of animation groups without a display.
+//!
+//! Usage: SpriteThumbnails [-j threads] [-c columns] [-o directory] group ...
+//!
+//!	- -j threads	Number of worker threads (default is the number of processors)
+//!	- -c columns	Maximum number of frames in a row of a contact sheet (default is 16)
+//!	- -o directory	Directory where the contact sheets are written (default is the current directory)
+//!
+//! Each animation of a group starts a new row of its contact sheet, and the frames of the animation are drawn in
+//! order. The contact sheet is written as a BMP file with the name of the group file. When all groups have been
+//! rendered, the throughput is reported in frames per second and frames per second per thread.
+//!
+//! Animation group file format
+//!
+//! A group file is a text file containing a list of commands, one per line:
+//!
+//! @code
+//!		sheet <file>								Image file containing the sheet (relative to the group file)
+//!		key <red> <green> <blue>					Color key of the sheet (optional)
+//!		image <x> <y> <w> <h> <offsetX> <offsetY>	Adds an image
+//!		animation <mode> <count> <image> <time> ...	Adds an animation with <count> frames. <mode> is one of "once",
+//!													"loop", or "pingpong". Times must be >= 0.
+//! @endcode
+
+#include "../Headless.h"
+#include "../Lock.h"
+#include "../Sdlx.h"
+#include "../Sprite.h"
+
+#include <SDL.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#if defined( _WIN32 )
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace Sdlx;
+
+namespace
+{
+
+	typedef AnimatedSprite::AnimationGroup	AnimationGroup;
+	typedef AnimatedSprite::Animation		Animation;
+
+	int const	CELL_SPACING	= 2;	// Space between the cells of a contact sheet
+
+
+	// An animation group and the sheet it uses
+
+	struct GroupDescription
+	{
+		std::string		sheet;		// Name of the sheet's image file
+		bool			colorKeyed;	// True if the sheet has a color key
+		SDL_Color		key;		// The sheet's color key
+		AnimationGroup	group;		// The animation group
+	};
+
+
+	// A group to be rendered
+
+	struct Job
+	{
+		std::string		filename;	// Name of the group file
+		int				frames;		// Number of frames rendered
+		bool			ok;			// True if the contact sheet was written
+	};
+
+
+	// The state of a worker thread
+
+	struct Worker
+	{
+		SDL_Thread *	pThread;		// The thread
+		int				frames;			// Number of frames rendered by the thread
+		Uint32			renderTime;		// Time spent rendering (in ms)
+	};
+
+
+	std::vector< Job >	s_jobs;				// All groups to be rendered
+	int					s_nextJob	= 0;	// Index of the next group to be rendered
+	SDL_mutex *			s_pMutex	= 0;	// Guards s_nextJob
+	int					s_columns	= 16;	// Maximum number of frames in a row of a contact sheet
+	std::string			s_outputDirectory;	// Where the contact sheets are written
+
+
+	// Returns the directory part of a path, including the trailing separator (or an empty string if none)
+
+	std::string DirectoryOf( std::string const & path )
+	{
+		std::string::size_type	slash	= path.find_last_of( "/\\" );
+
+		return ( slash != std::string::npos ) ? path.substr( 0, slash + 1 ) : std::string();
+	}
+
+
+	// Returns the name part of a path without the extension
+
+	std::string BaseNameOf( std::string const & path )
+	{
+		std::string				name	= path.substr( DirectoryOf( path ).size() );
+		std::string::size_type	dot		= name.rfind( '.' );
+
+		return ( dot != std::string::npos ) ? name.substr( 0, dot ) : name;
+	}
+
+
+	// Returns the number of processors
+
+	int ProcessorCount()
+	{
+#if defined( _WIN32 )
+		SYSTEM_INFO	info;
+
+		GetSystemInfo( &info );
+		return int( info.dwNumberOfProcessors );
+#else
+		long	count	= sysconf( _SC_NPROCESSORS_ONLN );
+
+		return ( count > 0 ) ? int( count ) : 1;
+#endif
+	}
+
+
+	// Loads an animation group file. Returns false if the file could not be loaded.
+
+	bool LoadGroup( char const * filename, GroupDescription * pDescription )
+	{
+		FILE *	fp	= fopen( filename, "r" );
+
+		if ( fp == 0 )
+		{
+			return false;
+		}
+
+		bool	ok	= true;
+		char	command[ 256 ];
+
+		pDescription->colorKeyed = false;
+
+		while ( ok && fscanf( fp, "%255s", command ) == 1 )
+		{
+			if ( strcmp( command, "sheet" ) == 0 )
+			{
+				char	sheet[ 1024 ]	= "";
+
+				ok = ( fscanf( fp, "%1023s", sheet ) == 1 );
+				if ( ok )
+				{
+					pDescription->sheet = ( sheet[0] == '/' ) ? std::string( sheet ) : DirectoryOf( filename ) + sheet;
+				}
+			}
+			else if ( strcmp( command, "key" ) == 0 )
+			{
+				int	r, g, b;
+
+				ok = ( fscanf( fp, "%d %d %d", &r, &g, &b ) == 3 );
+				if ( ok )
+				{
+					pDescription->colorKeyed	= true;
+					pDescription->key			= MakeColor( r, g, b );
+				}
+			}
+			else if ( strcmp( command, "image" ) == 0 )
+			{
+				int						x, y, w, h;
+				AnimationGroup::Image	image;
+
+				ok = ( fscanf( fp, "%d %d %d %d %d %d", &x, &y, &w, &h, &image.offsetX, &image.offsetY ) == 6 );
+				if ( ok )
+				{
+					image.rect = MakeRect( x, y, w, h );
+					pDescription->group.images.push_back( image );
+				}
+			}
+			else if ( strcmp( command, "animation" ) == 0 )
+			{
+				char		mode[ 16 ]	= "";
+				int			count		= 0;
+				Animation	animation;
+
+				ok = ( fscanf( fp, "%15s %d", mode, &count ) == 2 && count > 0 );
+
+				if		( !ok )								break;
+				else if ( strcmp( mode, "once" ) == 0 )		animation.mode = Animation::MODE_ONCE;
+				else if ( strcmp( mode, "loop" ) == 0 )		animation.mode = Animation::MODE_LOOP;
+				else if ( strcmp( mode, "pingpong" ) == 0 )	animation.mode = Animation::MODE_PINGPONG;
+				else										ok = false;
+
+				for ( int i = 0; ok && i < count; ++i )
+				{
+					AnimatedSprite::Frame	frame;
+
+					ok = ( fscanf( fp, "%d %f", &frame.index, &frame.time ) == 2 &&
+						   frame.index >= 0 && frame.index < int( pDescription->group.images.size() ) &&
+						   frame.time >= 0.0f );
+					if ( ok )
+					{
+						animation.frames.push_back( frame );
+					}
+				}
+
+				pDescription->group.animations.push_back( animation );
+			}
+			else
+			{
+				ok = false;
+			}
+		}
+
+		fclose( fp );
+
+		return ok && !pDescription->sheet.empty() && !pDescription->group.animations.empty();
+	}
+
+
+	// Draws every frame of every animation in the group into a new contact sheet. Returns the contact sheet, or 0
+	// if error.
+
+	SDL_Surface * RenderContactSheet( SDL_Surface * sheet, GroupDescription const & description, int * pFrames )
+	{
+		AnimationGroup const &	group	= description.group;
+
+		// Determine the size of the cells and the contact sheet
+
+		int	cellW	= 1;
+		int	cellH	= 1;
+
+		for ( AnimationGroup::ImageList::const_iterator i = group.images.begin(); i != group.images.end(); ++i )
+		{
+			cellW = std::max( cellW, int( i->rect.w ) );
+			cellH = std::max( cellH, int( i->rect.h ) );
+		}
+
+		int	columns	= 1;
+		int	rows	= 0;
+
+		for ( AnimationGroup::AnimationList::const_iterator i = group.animations.begin(); i != group.animations.end(); ++i )
+		{
+			int	frames	= int( i->frames.size() );
+
+			columns	= std::max( columns, std::min( frames, s_columns ) );
+			rows	+= ( frames + s_columns - 1 ) / s_columns;
+		}
+
+		SDL_Surface *	contactSheet	= CreateOffscreenSurface( columns * ( cellW + CELL_SPACING ) + CELL_SPACING,
+																  rows * ( cellH + CELL_SPACING ) + CELL_SPACING );
+		if ( contactSheet == 0 )
+		{
+			return 0;
+		}
+
+		SDL_Color	background	= description.colorKeyed ? description.key : MakeColor( 64, 64, 64 );
+
+		SDL_FillRect( contactSheet, 0, SDL_MapRGB( contactSheet->format, background.r, background.g, background.b ) );
+
+		// Draw the frames. Each cell is drawn directly from its frame's image, so the frame times do not matter.
+
+		int	row	= 0;
+
+		*pFrames = 0;
+
+		for ( int a = 0; a < int( group.animations.size() ); ++a )
+		{
+			Animation::FrameList const &	frames	= group.animations[ a ].frames;
+
+			for ( int f = 0; f < int( frames.size() ); ++f )
+			{
+				AnimationGroup::Image const &	image	= group.images[ frames[ f ].index ];
+
+				int	cellX	= CELL_SPACING + ( f % s_columns ) * ( cellW + CELL_SPACING );
+				int	cellY	= CELL_SPACING + ( row + f / s_columns ) * ( cellH + CELL_SPACING );
+
+				Sprite	cell( sheet, image.rect, image.offsetX, image.offsetY,
+							  float( cellX + image.offsetX ), float( cellY + image.offsetY ) );
+
+				cell.Draw( contactSheet );
+				++*pFrames;
+			}
+
+			row += ( int( frames.size() ) + s_columns - 1 ) / s_columns;
+		}
+
+		return contactSheet;
+	}
+
+
+	// Renders one group
+
+	void RenderJob( Job * pJob, Worker * pWorker )
+	{
+		GroupDescription	description;
+
+		pJob->frames	= 0;
+		pJob->ok		= false;
+
+		if ( !LoadGroup( pJob->filename.c_str(), &description ) )
+		{
+			fprintf( stderr, "SpriteThumbnails: unable to load group \"%s\"\n", pJob->filename.c_str() );
+			return;
+		}
+
+		SDL_Surface *	sheet	= description.colorKeyed
+								? LoadColorKeyedImage( description.sheet.c_str(), description.key, GetHeadlessFormat() )
+								: LoadImage( description.sheet.c_str(), GetHeadlessFormat() );
+		if ( sheet == 0 )
+		{
+			fprintf( stderr, "SpriteThumbnails: unable to load sheet \"%s\"\n", description.sheet.c_str() );
+			return;
+		}
+
+		Uint32			start			= SDL_GetTicks();
+		SDL_Surface *	contactSheet	= RenderContactSheet( sheet, description, &pJob->frames );
+
+		pWorker->renderTime	+= SDL_GetTicks() - start;
+		pWorker->frames		+= pJob->frames;
+
+		if ( contactSheet != 0 )
+		{
+			std::string	output	= s_outputDirectory + BaseNameOf( pJob->filename ) + ".bmp";
+
+			pJob->ok = ( SDL_SaveBMP( contactSheet, output.c_str() ) == 0 );
+			if ( !pJob->ok )
+			{
+				fprintf( stderr, "SpriteThumbnails: unable to write \"%s\"\n", output.c_str() );
+			}
+
+			SDL_FreeSurface( contactSheet );
+		}
+
+		FreeImage( sheet );
+	}
+
+
+	// Renders groups until there are none left
+
+	int WorkerMain( void * pData )
+	{
+		Worker *	pWorker	= static_cast< Worker * >( pData );
+
+		for ( ;; )
+		{
+			int	index;
+
+			{
+				Lock	lock( s_pMutex );
+
+				index = s_nextJob++;
+			}
+
+			if ( index >= int( s_jobs.size() ) )
+			{
+				break;
+			}
+
+			RenderJob( &s_jobs[ index ], pWorker );
+		}
+
+		return 0;
+	}
+
+
+	void Usage()
+	{
+		fprintf( stderr, "usage: SpriteThumbnails [-j threads] [-c columns] [-o directory] group ...\n" );
+	}
+
+
+} // anonymous namespace
+
+
+/********************************************************************************************************************/
+/*																													*/
+/********************************************************************************************************************/
+
+int main( int argc, char * argv[] )
+{
+	int	threadCount	= ProcessorCount();
+
+	// Parse the command line
+
+	for ( int i = 1; i < argc; ++i )
+	{
+		if ( strcmp( argv[i], "-j" ) == 0 && i + 1 < argc )
+		{
+			threadCount = std::max( atoi( argv[++i] ), 1 );
+		}
+		else if ( strcmp( argv[i], "-c" ) == 0 && i + 1 < argc )
+		{
+			s_columns = std::max( atoi( argv[++i] ), 1 );
+		}
+		else if ( strcmp( argv[i], "-o" ) == 0 && i + 1 < argc )
+		{
+			s_outputDirectory = argv[++i];
+			if ( !s_outputDirectory.empty() && DirectoryOf( s_outputDirectory ) != s_outputDirectory )
+			{
+				s_outputDirectory += '/';
+			}
+		}
+		else if ( argv[i][0] == '-' )
+		{
+			Usage();
+			return 1;
+		}
+		else
+		{
+			Job	job	= { argv[i], 0, false };
+
+			s_jobs.push_back( job );
+		}
+	}
+
+	if ( s_jobs.empty() )
+	{
+		Usage();
+		return 1;
+	}
+
+	if ( !InitHeadless() )
+	{
+		fprintf( stderr, "SpriteThumbnails: unable to initialize SDL: %s\n", SDL_GetError() );
+		return 1;
+	}
+
+	s_pMutex = SDL_CreateMutex();
+
+	// Render all the groups
+
+	threadCount = std::min( threadCount, int( s_jobs.size() ) );
+
+	std::vector< Worker >	workers( threadCount );
+	Uint32					start	= SDL_GetTicks();
+
+	for ( int i = 0; i < threadCount; ++i )
+	{
+		workers[i].frames		= 0;
+		workers[i].renderTime	= 0;
+		workers[i].pThread		= SDL_CreateThread( WorkerMain, &workers[i] );
+		assert( workers[i].pThread != 0 );
+	}
+
+	int		frames		= 0;
+	Uint32	renderTime	= 0;
+
+	for ( int i = 0; i < threadCount; ++i )
+	{
+		SDL_WaitThread( workers[i].pThread, 0 );
+		frames		+= workers[i].frames;
+		renderTime	+= workers[i].renderTime;
+	}
+
+	Uint32	elapsed	= std::max( SDL_GetTicks() - start, Uint32( 1 ) );
+
+	// Report the results
+
+	int	failures	= 0;
+
+	for ( std::vector< Job >::const_iterator i = s_jobs.begin(); i != s_jobs.end(); ++i )
+	{
+		if ( !i->ok )
+		{
+			++failures;
+		}
+	}
+
+	printf( "%d groups (%d failed), %d frames, %d threads, %u ms\n",
+			int( s_jobs.size() ), failures, frames, threadCount, elapsed );
+	printf( "%.1f frames/s, %.1f frames/s/thread (%.1f frames/s/thread excluding loading and saving)\n",
+			frames * 1000.0 / elapsed,
+			frames * 1000.0 / elapsed / threadCount,
+			frames * 1000.0 / std::max( renderTime, Uint32( 1 ) ) );
+
+	SDL_DestroyMutex( s_pMutex );
+	QuitHeadless();
+
+	return ( failures == 0 ) ? 0 : 1;
+}